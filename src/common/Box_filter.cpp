@@ -0,0 +1,80 @@
+#include "common/Box_filter.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define BOX_FILTER_SSE2
+#endif
+
+static uint32_t average(uint32_t a, uint32_t b, uint32_t c, uint32_t d) {
+    uint32_t output = 0;
+
+    for(int shift = 0; shift < 32; shift += 8) {
+        const uint32_t sum = (a >> shift & 0xff) + (b >> shift & 0xff) + (c >> shift & 0xff) + (d >> shift & 0xff);
+        output |= (sum + 2) / 4 << shift;
+    }
+    return output;
+}
+
+/** Halve the columns from first_x of two input rows, which may be the same row. */
+static void halve_row_scalar(const uint32_t* row_0, const uint32_t* row_1, int first_x, int width, uint32_t* output) {
+    for(int x = first_x; x < width; x += 2) {
+        const int next_x = std::min(x + 1, width - 1);
+        output[x / 2] = average(row_0[x], row_0[next_x], row_1[x], row_1[next_x]);
+    }
+}
+
+#ifdef BOX_FILTER_SSE2
+/** Halve eight input columns to four output pixels. */
+static __m128i halve_8_sse2(const uint32_t* row_0, const uint32_t* row_1) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i top_0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0));
+    const __m128i top_1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_0 + 4));
+    const __m128i bottom_0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1));
+    const __m128i bottom_1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row_1 + 4));
+
+    // Vertical sums of the channels as 16-bit values, two pixels per vector.
+    const __m128i sum_01 = _mm_add_epi16(_mm_unpacklo_epi8(top_0, zero), _mm_unpacklo_epi8(bottom_0, zero));
+    const __m128i sum_23 = _mm_add_epi16(_mm_unpackhi_epi8(top_0, zero), _mm_unpackhi_epi8(bottom_0, zero));
+    const __m128i sum_45 = _mm_add_epi16(_mm_unpacklo_epi8(top_1, zero), _mm_unpacklo_epi8(bottom_1, zero));
+    const __m128i sum_67 = _mm_add_epi16(_mm_unpackhi_epi8(top_1, zero), _mm_unpackhi_epi8(bottom_1, zero));
+
+    // Even and odd columns are gathered so adding them sums each pair.
+    const __m128i rounding = _mm_set1_epi16(2);
+    __m128i low = _mm_add_epi16(_mm_unpacklo_epi64(sum_01, sum_23), _mm_unpackhi_epi64(sum_01, sum_23));
+    __m128i high = _mm_add_epi16(_mm_unpacklo_epi64(sum_45, sum_67), _mm_unpackhi_epi64(sum_45, sum_67));
+    low = _mm_srli_epi16(_mm_add_epi16(low, rounding), 2);
+    high = _mm_srli_epi16(_mm_add_epi16(high, rounding), 2);
+    return _mm_packus_epi16(low, high);
+}
+
+void Box_filter::halve_rgb32(const uint32_t* input, int width, int height, size_t input_stride,
+    uint32_t* output, size_t output_stride) {
+    for(int y = 0; y < height; y += 2) {
+        const uint32_t* row_0 = input + static_cast<size_t>(y) * input_stride;
+        const uint32_t* row_1 = input + static_cast<size_t>(std::min(y + 1, height - 1)) * input_stride;
+        uint32_t* output_row = output + static_cast<size_t>(y / 2) * output_stride;
+        int x = 0;
+
+        for(; x + 8 <= width; x += 8) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(output_row + x / 2), halve_8_sse2(row_0 + x, row_1 + x));
+        }
+        halve_row_scalar(row_0, row_1, x, width, output_row);
+    }
+}
+#else
+void Box_filter::halve_rgb32(const uint32_t* input, int width, int height, size_t input_stride,
+    uint32_t* output, size_t output_stride) {
+    halve_rgb32_scalar(input, width, height, input_stride, output, output_stride);
+}
+#endif
+
+void Box_filter::halve_rgb32_scalar(const uint32_t* input, int width, int height, size_t input_stride,
+    uint32_t* output, size_t output_stride) {
+    for(int y = 0; y < height; y += 2) {
+        const uint32_t* row_0 = input + static_cast<size_t>(y) * input_stride;
+        const uint32_t* row_1 = input + static_cast<size_t>(std::min(y + 1, height - 1)) * input_stride;
+        halve_row_scalar(row_0, row_1, 0, width, output + static_cast<size_t>(y / 2) * output_stride);
+    }
+}
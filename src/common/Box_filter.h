@@ -0,0 +1,16 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Box_filter
+{
+    /** Halve an image of 0xAARRGGBB pixels by averaging each 2x2 block, rounded
+     *  to nearest. An odd last column or row is averaged with itself. The output
+     *  is (width + 1) / 2 by (height + 1) / 2 pixels. Strides are in pixels.
+     *  Uses SSE2 where available. */
+    void halve_rgb32(const uint32_t* input, int width, int height, size_t input_stride,
+        uint32_t* output, size_t output_stride);
+    /** Same result as halve_rgb32, without SIMD. */
+    void halve_rgb32_scalar(const uint32_t* input, int width, int height, size_t input_stride,
+        uint32_t* output, size_t output_stride);
+}
@@ -7,8 +7,20 @@
 #include <dcmtk/dcmdata/dcitem.h>
 #include <dcmtk/dcmdata/dcpath.h>
 #include <dcmtk/dcmdata/dcsequen.h>
+#include <dcmtk/dcmdata/dcvr.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
 #include <stdexcept>
 
+const size_t dicom_preamble_length{128};
+const std::array<char, 4> dicom_prefix{'D', 'I', 'C', 'M'};
+const uint16_t meta_group{0x0002};
+const uint16_t identifying_group{0x0008};
+const uint32_t max_first_element_length{0x10000};
+const uint32_t undefined_length{0xffffffff};
+
 static DcmObject* get_object(DcmPath* path) {
     DcmPathNode* last_node = path->back();
     DcmObject* object = last_node ? last_node->m_obj : nullptr;
@@ -19,6 +31,45 @@ static DcmObject* get_object(DcmPath* path) {
     return object;
 }
 
+static uint16_t read_uint16(const char* data, bool little_endian) {
+    const auto b0 = static_cast<unsigned char>(data[0]);
+    const auto b1 = static_cast<unsigned char>(data[1]);
+    return static_cast<uint16_t>(little_endian ? b0 | b1 << 8 : b0 << 8 | b1);
+}
+
+static uint32_t read_uint32(const char* data, bool little_endian) {
+    const uint32_t low = read_uint16(little_endian ? data : data + 2, little_endian);
+    const uint32_t high = read_uint16(little_endian ? data + 2 : data, little_endian);
+    return low | high << 16;
+}
+
+/** Files without preamble start directly with the dataset. Accept them if the
+ *  first element is in the meta or identifying group and has either an explicit
+ *  VR or a sensible implicit VR length. */
+static bool starts_with_element(const char* data, size_t size) {
+    if(size < 8) {
+        return false;
+    }
+    for(bool little_endian : {true, false}) {
+        const uint16_t group = read_uint16(data, little_endian);
+
+        if(group != meta_group && group != identifying_group) {
+            continue;
+        }
+        const char vr_name[3] = {data[4], data[5], '\0'};
+
+        if(DcmVR(vr_name).isStandard()) {
+            return true;
+        }
+        const uint32_t length = read_uint32(data + 4, little_endian);
+
+        if(length == undefined_length || (length <= max_first_element_length && length % 2 == 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 static void set_element_value(const OFList<DcmPath*>& paths, const std::string& value) {
     for(DcmPath* path : paths) {
         auto element = dynamic_cast<DcmElement*>(get_object(path));
@@ -104,3 +155,41 @@ int Dicom_util::get_index_nr(DcmObject& object) {
     Log::error("Could not get index of object. Parent VR: " + std::to_string(vr));
     return -1;
 }
+
+DcmTagKey Dicom_util::get_top_level_tag(DcmObject& object) {
+    DcmObject* top_level_object = &object;
+
+    while(DcmObject* parent = top_level_object->getParent()) {
+        const DcmEVR vr = parent->ident();
+
+        if(vr == EVR_dataset || vr == EVR_metainfo) {
+            break;
+        }
+        top_level_object = parent;
+    }
+    return top_level_object->getTag();
+}
+
+DcmTagKey Dicom_util::get_top_level_tag(const std::string& tag_path) {
+    OFString path(tag_path.c_str());
+    DcmTag tag;
+    OFCondition status = DcmPath::parseTagFromPath(path, tag);
+
+    if(status.bad()) {
+        throw Tag_path_not_found_error(status.text());
+    }
+    return tag;
+}
+
+bool Dicom_util::looks_like_dicom(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios_base::binary);
+    std::array<char, dicom_preamble_length + dicom_prefix.size()> header{};
+    file.read(header.data(), header.size());
+    const auto read_count = static_cast<size_t>(file.gcount());
+
+    if(read_count == header.size()
+        && std::equal(dicom_prefix.begin(), dicom_prefix.end(), header.begin() + dicom_preamble_length)) {
+        return true;
+    }
+    return starts_with_element(header.data(), read_count);
+}
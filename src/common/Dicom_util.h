@@ -1,5 +1,7 @@
 #pragma once
 #include <dcmtk/dcmdata/dcobject.h>
+#include <dcmtk/dcmdata/dctagkey.h>
+#include <filesystem>
 #include <string>
 
 namespace Dicom_util
@@ -7,4 +9,12 @@ namespace Dicom_util
     void set_element(const std::string& tag_path, const std::string& value, bool create_if_needed, DcmObject&);
     void delete_element(const std::string& tag_path, DcmObject&);
     int get_index_nr(DcmObject&);
+    /** Returns the tag of the dataset or meta header element that contains the object. */
+    DcmTagKey get_top_level_tag(DcmObject&);
+    /** Returns the tag of the first element in the tag path. */
+    DcmTagKey get_top_level_tag(const std::string& tag_path);
+    /** Cheap check of the first bytes of a file. Returns true if the file has the
+     *  DICM prefix after the preamble or starts with a plausible group 0002 or 0008
+     *  element. Files rejected here are not DICOM files DCMTK could load. */
+    bool looks_like_dicom(const std::filesystem::path&);
 }
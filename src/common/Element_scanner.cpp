@@ -0,0 +1,259 @@
+#include "common/Element_scanner.h"
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <array>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+const uint64_t preamble_length{128};
+const uint32_t undefined_length{0xffffffff};
+const uint16_t meta_group{0x0002};
+const DcmTagKey item_tag{0xfffe, 0xe000};
+const DcmTagKey item_delimitation_tag{0xfffe, 0xe00d};
+const DcmTagKey sequence_delimitation_tag{0xfffe, 0xe0dd};
+const int max_nesting_depth{64};
+
+struct Element_header
+{
+    DcmTagKey tag;
+    uint32_t length = 0;
+    uint64_t header_size = 0;
+};
+
+class Element_reader
+{
+public:
+    Element_reader(const fs::path& path)
+        : m_file(path, std::ios_base::binary) {
+        if(!m_file.is_open()) {
+            throw std::runtime_error("failed to open file");
+        }
+        m_file.seekg(0, std::ios_base::end);
+        m_size = static_cast<uint64_t>(m_file.tellg());
+        m_file.seekg(0);
+    }
+
+    uint64_t size() const {return m_size;}
+    uint64_t position() {return static_cast<uint64_t>(m_file.tellg());}
+    bool at_end() {return position() >= m_size;}
+
+    void read(char* data, size_t length) {
+        m_file.read(data, static_cast<std::streamsize>(length));
+
+        if(!m_file) {
+            throw std::runtime_error("unexpected end of file");
+        }
+    }
+
+    uint32_t read_uint(int byte_count) {
+        std::array<unsigned char, 4> bytes{};
+        read(reinterpret_cast<char*>(bytes.data()), byte_count);
+        uint32_t value = 0;
+        for(int i = byte_count - 1; i >= 0; --i) {
+            value = value << 8 | bytes[i];
+        }
+        return value;
+    }
+
+    void skip(uint64_t length) {
+        if(position() + length > m_size) {
+            throw std::runtime_error("element extends past end of file");
+        }
+        m_file.seekg(static_cast<std::streamoff>(length), std::ios_base::cur);
+    }
+
+    /** Read bytes at offset without moving the read position. */
+    std::string read_at(uint64_t offset, uint64_t length) {
+        const uint64_t start = position();
+
+        if(offset + length > m_size) {
+            throw std::runtime_error("element extends past end of file");
+        }
+        std::string data(length, '\0');
+        m_file.seekg(static_cast<std::streamoff>(offset));
+        read(data.data(), data.size());
+        m_file.seekg(static_cast<std::streamoff>(start));
+        return data;
+    }
+
+    /** Read the group number of the next element without consuming it. */
+    uint16_t peek_group() {
+        const uint64_t start = position();
+        const auto group = static_cast<uint16_t>(read_uint(2));
+        m_file.seekg(static_cast<std::streamoff>(start));
+        return group;
+    }
+
+private:
+    std::ifstream m_file;
+    uint64_t m_size;
+};
+
+static bool has_long_length(const char* vr) {
+    static const std::array<const char*, 13> long_vrs = {
+        "OB", "OD", "OF", "OL", "OV", "OW", "SQ", "SV", "UC", "UN", "UR", "UT", "UV"};
+
+    for(const char* long_vr : long_vrs) {
+        if(vr[0] == long_vr[0] && vr[1] == long_vr[1]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static Element_header read_header(Element_reader& reader, bool explicit_vr) {
+    Element_header header;
+    const auto group = static_cast<Uint16>(reader.read_uint(2));
+    const auto element = static_cast<Uint16>(reader.read_uint(2));
+    header.tag = DcmTagKey(group, element);
+
+    // Item and delimitation tags never have a VR.
+    if(!explicit_vr || group == 0xfffe) {
+        header.length = reader.read_uint(4);
+        header.header_size = 8;
+        return header;
+    }
+    char vr[2];
+    reader.read(vr, 2);
+
+    if(has_long_length(vr)) {
+        reader.skip(2);
+        header.length = reader.read_uint(4);
+        header.header_size = 12;
+    }
+    else {
+        header.length = reader.read_uint(2);
+        header.header_size = 8;
+    }
+    return header;
+}
+
+static void skip_undefined_length_value(Element_reader&, bool explicit_vr, int depth);
+
+/** Skip elements until the item delimitation. */
+static void skip_undefined_length_item(Element_reader& reader, bool explicit_vr, int depth) {
+    while(true) {
+        const Element_header header = read_header(reader, explicit_vr);
+
+        if(header.tag == item_delimitation_tag) {
+            return;
+        }
+        if(header.length == undefined_length) {
+            skip_undefined_length_value(reader, explicit_vr, depth + 1);
+        }
+        else {
+            reader.skip(header.length);
+        }
+    }
+}
+
+/** Skip the items of a sequence or encapsulated pixel data until the sequence delimitation. */
+static void skip_undefined_length_value(Element_reader& reader, bool explicit_vr, int depth) {
+    if(depth > max_nesting_depth) {
+        throw std::runtime_error("sequences are nested too deeply");
+    }
+    while(true) {
+        const Element_header header = read_header(reader, false);
+
+        if(header.tag == sequence_delimitation_tag) {
+            return;
+        }
+        if(header.tag != item_tag) {
+            throw std::runtime_error("expected item in sequence");
+        }
+        if(header.length == undefined_length) {
+            skip_undefined_length_item(reader, explicit_vr, depth);
+        }
+        else {
+            reader.skip(header.length);
+        }
+    }
+}
+
+/** Read the locations of the items of encapsulated pixel data until the sequence delimitation. */
+static std::vector<Element_location> read_fragments(Element_reader& reader) {
+    std::vector<Element_location> items;
+
+    while(true) {
+        Element_location item;
+        item.offset = reader.position();
+        const Element_header header = read_header(reader, false);
+
+        if(header.tag == sequence_delimitation_tag) {
+            return items;
+        }
+        if(header.tag != item_tag || header.length == undefined_length) {
+            throw std::runtime_error("expected fragment in encapsulated pixel data");
+        }
+        reader.skip(header.length);
+        item.tag = header.tag;
+        item.size = header.header_size + header.length;
+        items.push_back(item);
+    }
+}
+
+static Element_location read_element(Element_reader& reader, bool explicit_vr) {
+    Element_location location;
+    location.offset = reader.position();
+    const Element_header header = read_header(reader, explicit_vr);
+    location.tag = header.tag;
+
+    if(header.length == undefined_length) {
+        location.undefined_length = true;
+
+        if(header.tag == DCM_PixelData) {
+            location.items = read_fragments(reader);
+        }
+        else {
+            skip_undefined_length_value(reader, explicit_vr, 0);
+        }
+    }
+    else {
+        reader.skip(header.length);
+    }
+    location.size = reader.position() - location.offset;
+    return location;
+}
+
+static E_TransferSyntax read_transfer_syntax(Element_reader& reader, const Element_location& location) {
+    // Meta elements always have explicit VR with a short length.
+    std::string uid = reader.read_at(location.offset + 8, location.size - 8);
+
+    while(!uid.empty() && (uid.back() == '\0' || uid.back() == ' ')) {
+        uid.pop_back();
+    }
+    return DcmXfer(uid.c_str()).getXfer();
+}
+
+File_layout Element_scanner::scan_file(const fs::path& path) {
+    Element_reader reader(path);
+    File_layout layout;
+    layout.file_size = reader.size();
+    std::array<char, 4> prefix{};
+    reader.skip(preamble_length);
+    reader.read(prefix.data(), prefix.size());
+
+    if(prefix != std::array<char, 4>{'D', 'I', 'C', 'M'}) {
+        throw std::runtime_error("file has no meta header");
+    }
+    while(!reader.at_end() && reader.peek_group() == meta_group) {
+        layout.meta_elements.push_back(read_element(reader, true));
+    }
+    for(const Element_location& location : layout.meta_elements) {
+        if(location.tag == DCM_TransferSyntaxUID) {
+            layout.transfer_syntax = read_transfer_syntax(reader, location);
+        }
+    }
+    const DcmXfer transfer_syntax(layout.transfer_syntax);
+
+    if(layout.transfer_syntax == EXS_Unknown || !transfer_syntax.isLittleEndian()
+        || transfer_syntax.getStreamCompression() != ESC_none) {
+        throw std::runtime_error("unsupported transfer syntax");
+    }
+    while(!reader.at_end()) {
+        layout.dataset_elements.push_back(read_element(reader, transfer_syntax.isExplicitVR()));
+    }
+    return layout;
+}
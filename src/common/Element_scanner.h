@@ -0,0 +1,36 @@
+#pragma once
+#include <dcmtk/dcmdata/dctagkey.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <cstdint>
+#include <filesystem>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/** Byte range of an encoded element, including its tag, VR and length. */
+struct Element_location
+{
+    DcmTagKey tag;
+    uint64_t offset = 0;
+    uint64_t size = 0;
+    bool undefined_length = false;
+    /** Items of encapsulated pixel data, the basic offset table followed by the
+     *  fragments. Empty for other elements. */
+    std::vector<Element_location> items;
+};
+
+struct File_layout
+{
+    E_TransferSyntax transfer_syntax = EXS_Unknown;
+    std::vector<Element_location> meta_elements;
+    /** Top-level elements of the dataset. Nested items are not listed. */
+    std::vector<Element_location> dataset_elements;
+    uint64_t file_size = 0;
+};
+
+namespace Element_scanner
+{
+    /** Scan a file with preamble and meta header without parsing values. Only
+     *  little endian transfer syntaxes are supported, others throw. */
+    File_layout scan_file(const fs::path&);
+}
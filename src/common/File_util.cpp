@@ -0,0 +1,304 @@
+#include "common/File_util.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+#include <sys/xattr.h>
+#endif
+
+const size_t copy_buffer_size{1024 * 1024};
+const uint64_t max_copy_chunk{1024 * 1024 * 1024};
+/* Same limit as Linux, which fails with ELOOP beyond it. */
+const int max_symlink_depth{40};
+/* Temporary files are hidden, and have a fixed length name so that a long file
+*  name can still be saved. */
+const std::string temp_file_prefix{".dcmedit-"};
+const std::string temp_file_extension{".tmp"};
+const int max_temp_file_attempts{16};
+
+size_t File_identity_hash::operator()(const File_identity& identity) const {
+    std::hash<uint64_t> hash;
+    return hash(identity.file) ^ (hash(identity.device) * 31);
+}
+
+#ifdef _WIN32
+File_identity File_util::get_identity(const fs::path& path) {
+    File_identity identity;
+    HANDLE handle = CreateFileW(path.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+
+    if(handle == INVALID_HANDLE_VALUE) {
+        return identity;
+    }
+    BY_HANDLE_FILE_INFORMATION info;
+
+    if(GetFileInformationByHandle(handle, &info)) {
+        identity.device = info.dwVolumeSerialNumber;
+        identity.file = (static_cast<uint64_t>(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+        identity.valid = true;
+    }
+    CloseHandle(handle);
+    return identity;
+}
+#else
+File_identity File_util::get_identity(const fs::path& path) {
+    File_identity identity;
+    struct stat info;
+
+    if(stat(path.c_str(), &info) == 0) {
+        identity.device = static_cast<uint64_t>(info.st_dev);
+        identity.file = static_cast<uint64_t>(info.st_ino);
+        identity.valid = true;
+    }
+    return identity;
+}
+#endif
+
+std::string File_util::get_canonical_key(const fs::path& path) {
+    std::error_code error;
+    fs::path canonical = fs::weakly_canonical(path, error);
+
+    if(error) {
+        canonical = fs::absolute(path, error).lexically_normal();
+    }
+    return canonical.string();
+}
+
+static void append_file_range_buffered(const fs::path& source, uint64_t offset, uint64_t length, const fs::path& target) {
+    std::ifstream input(source, std::ios_base::binary);
+    std::ofstream output(target, std::ios_base::binary | std::ios_base::app);
+
+    if(!input.is_open() || !output.is_open()) {
+        throw std::runtime_error("failed to open file");
+    }
+    input.seekg(static_cast<std::streamoff>(offset));
+    std::vector<char> buffer(copy_buffer_size);
+
+    while(length > 0) {
+        const auto count = static_cast<std::streamsize>(std::min<uint64_t>(length, buffer.size()));
+        input.read(buffer.data(), count);
+
+        if(input.gcount() != count) {
+            throw std::runtime_error("unexpected end of file");
+        }
+        output.write(buffer.data(), count);
+        length -= static_cast<uint64_t>(count);
+    }
+    output.close();
+
+    if(!output) {
+        throw std::runtime_error("failed to write file");
+    }
+}
+
+#ifdef __linux__
+void File_util::append_file_range(const fs::path& source, uint64_t offset, uint64_t length, const fs::path& target) {
+    const int input = open(source.c_str(), O_RDONLY | O_CLOEXEC);
+    const int output = open(target.c_str(), O_WRONLY | O_CLOEXEC);
+    auto input_offset = static_cast<loff_t>(offset);
+
+    if(input >= 0 && output >= 0 && lseek(output, 0, SEEK_END) >= 0) {
+        while(length > 0) {
+            const auto count = static_cast<size_t>(std::min(length, max_copy_chunk));
+            const ssize_t copied = copy_file_range(input, &input_offset, output, nullptr, count, 0);
+
+            if(copied < 0 && errno == EINTR) {
+                continue;
+            }
+            // Some file systems do not support copy_file_range, the rest is copied through a buffer.
+            if(copied <= 0) {
+                break;
+            }
+            length -= static_cast<uint64_t>(copied);
+        }
+    }
+    if(input >= 0) {
+        close(input);
+    }
+    if(output >= 0) {
+        close(output);
+    }
+    if(length > 0) {
+        append_file_range_buffered(source, static_cast<uint64_t>(input_offset), length, target);
+    }
+}
+#else
+void File_util::append_file_range(const fs::path& source, uint64_t offset, uint64_t length, const fs::path& target) {
+    append_file_range_buffered(source, offset, length, target);
+}
+#endif
+
+fs::path File_util::resolve_symlinks(const fs::path& path) {
+    fs::path target = path;
+    std::error_code error;
+
+    for(int i = 0; fs::is_symlink(target, error); ++i) {
+        if(i == max_symlink_depth) {
+            throw std::runtime_error("too many levels of symbolic links: " + path.string());
+        }
+        const fs::path link = fs::read_symlink(target);
+        target = link.is_absolute() ? link : target.parent_path() / link;
+    }
+    return target;
+}
+
+#ifdef _WIN32
+static bool create_new_file(const fs::path& path) {
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if(handle == INVALID_HANDLE_VALUE) {
+        if(GetLastError() == ERROR_FILE_EXISTS) {
+            return false;
+        }
+        throw std::runtime_error("failed to create file: " + path.string());
+    }
+    CloseHandle(handle);
+    return true;
+}
+#else
+static bool create_new_file(const fs::path& path) {
+    // Unlike mkstemp, the file gets the permissions of a new file, as the saved file should.
+    const int file = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+
+    if(file < 0) {
+        if(errno == EEXIST) {
+            return false;
+        }
+        throw std::runtime_error("failed to create file: " + path.string());
+    }
+    close(file);
+    return true;
+}
+#endif
+
+fs::path File_util::create_temp_file(const fs::path& path) {
+    std::random_device random;
+    std::uniform_int_distribution<uint64_t> distribution;
+
+    for(int i = 0; i < max_temp_file_attempts; ++i) {
+        std::ostringstream name;
+        name << temp_file_prefix << std::hex << std::setw(16) << std::setfill('0') << distribution(random)
+            << temp_file_extension;
+        const fs::path temp_path = path.parent_path() / name.str();
+
+        if(create_new_file(temp_path)) {
+            return temp_path;
+        }
+    }
+    throw std::runtime_error("failed to create a temporary file next to: " + path.string());
+}
+
+bool File_util::is_temp_path(const fs::path& path) {
+    const std::string name = path.filename().string();
+    return name.compare(0, temp_file_prefix.size(), temp_file_prefix) == 0
+        && path.extension() == temp_file_extension;
+}
+
+void File_util::replace_contents(const fs::path& source, const fs::path& target) {
+    fs::resize_file(target, 0);
+    append_file_range(source, 0, fs::file_size(source), target);
+    sync_file(target);
+}
+
+#ifdef _WIN32
+bool File_util::copy_attributes(const fs::path& source, const fs::path& target) {
+    fs::permissions(target, fs::status(source).permissions());
+    return true;
+}
+#else
+#ifdef __linux__
+static bool copy_access_control_list(const fs::path& source, const fs::path& target) {
+    const char* name = "system.posix_acl_access";
+    const ssize_t size = getxattr(source.c_str(), name, nullptr, 0);
+
+    // Without an access control list, or support for them, the permissions are all there is.
+    if(size < 0) {
+        return errno == ENODATA || errno == ENOTSUP;
+    }
+    std::vector<char> value(static_cast<size_t>(size));
+    const ssize_t read_size = getxattr(source.c_str(), name, value.data(), value.size());
+    return read_size >= 0 && setxattr(target.c_str(), name, value.data(), static_cast<size_t>(read_size), 0) == 0;
+}
+#endif
+
+bool File_util::copy_attributes(const fs::path& source, const fs::path& target) {
+    struct stat info;
+
+    if(stat(source.c_str(), &info) != 0) {
+        throw std::runtime_error("failed to read attributes of: " + source.string());
+    }
+    // The owner is set first, since changing it clears the set-user-ID bit.
+    bool copied = chown(target.c_str(), info.st_uid, info.st_gid) == 0;
+
+    if(!copied && errno != EPERM) {
+        throw std::runtime_error("failed to set owner of: " + target.string());
+    }
+    if(chmod(target.c_str(), info.st_mode & 07777) != 0) {
+        throw std::runtime_error("failed to set permissions of: " + target.string());
+    }
+#ifdef __linux__
+    copied = copy_access_control_list(source, target) && copied;
+#endif
+    return copied;
+}
+#endif
+
+#ifdef _WIN32
+void File_util::sync_file(const fs::path& path) {
+    HANDLE handle = CreateFileW(path.c_str(), GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if(handle == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("failed to open file for syncing");
+    }
+    const bool flushed = FlushFileBuffers(handle);
+    CloseHandle(handle);
+
+    if(!flushed) {
+        throw std::runtime_error("failed to sync file");
+    }
+}
+
+void File_util::sync_directory(const fs::path&) {}
+#else
+static void sync_path(const fs::path& path, int flags) {
+    const int file = open(path.empty() ? "." : path.c_str(), flags | O_CLOEXEC);
+
+    if(file < 0) {
+        throw std::runtime_error("failed to open for syncing: " + path.string());
+    }
+    const int result = fsync(file);
+    close(file);
+
+    if(result != 0) {
+        throw std::runtime_error("failed to sync: " + path.string());
+    }
+}
+
+void File_util::sync_file(const fs::path& path) {
+    sync_path(path, O_RDONLY);
+}
+
+void File_util::sync_directory(const fs::path& directory) {
+    sync_path(directory, O_RDONLY | O_DIRECTORY);
+}
+#endif
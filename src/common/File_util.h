@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+/** Identifies a file independently of the path used to reach it,
+ *  e.g. device and inode number on POSIX systems.
+ */
+struct File_identity
+{
+    uint64_t device = 0;
+    uint64_t file = 0;
+    bool valid = false;
+
+    bool operator==(const File_identity& other) const {
+        return valid == other.valid && device == other.device && file == other.file;
+    }
+};
+
+struct File_identity_hash
+{
+    size_t operator()(const File_identity&) const;
+};
+
+namespace File_util
+{
+    /** Returns an invalid identity if the file does not exist. */
+    File_identity get_identity(const fs::path&);
+    /** Returns a canonical form of the path, usable as a lookup key. */
+    std::string get_canonical_key(const fs::path&);
+    /** Append length bytes of source, starting at offset, to the end of target. On Linux
+     *  the data is copied by the kernel with copy_file_range. Throws on failure. */
+    void append_file_range(const fs::path& source, uint64_t offset, uint64_t length, const fs::path& target);
+    /** Follow symbolic links, also dangling ones, to the path they end at.
+     *  Other paths are returned unchanged. */
+    fs::path resolve_symlinks(const fs::path&);
+    /** Create an empty temporary file with a unique name in the directory of path,
+     *  so it can replace path by renaming. Throws on failure. */
+    fs::path create_temp_file(const fs::path&);
+    /** Returns true if the file name is one given by create_temp_file. */
+    bool is_temp_path(const fs::path&);
+    /** Give target the permissions, owner and group of source, and on Linux its access
+     *  control list. Returns false if the owner, group or access control list could not
+     *  be set, which needs more rights than the permissions. Throws on other failures. */
+    bool copy_attributes(const fs::path& source, const fs::path& target);
+    /** Overwrite the contents of target with those of source and flush them to disk.
+     *  The target keeps its identity and attributes, but unlike a rename this is not
+     *  atomic. Throws on failure. */
+    void replace_contents(const fs::path& source, const fs::path& target);
+    /** Flush the data of the file to disk. Throws on failure. */
+    void sync_file(const fs::path&);
+    /** Flush renames in the directory to disk. Does nothing on Windows, where
+     *  renames are made durable by the file system. */
+    void sync_directory(const fs::path&);
+}
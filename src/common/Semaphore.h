@@ -0,0 +1,50 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+class Semaphore
+{
+public:
+    explicit Semaphore(size_t count)
+        : m_count(count) {}
+
+    void acquire() {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_released.wait(lock, [this] {return m_count > 0;});
+        --m_count;
+    }
+
+    void release() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            ++m_count;
+        }
+        m_released.notify_one();
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_released;
+    size_t m_count;
+};
+
+/** Holds a semaphore for the lifetime of the guard. */
+class Semaphore_guard
+{
+public:
+    explicit Semaphore_guard(Semaphore& semaphore)
+        : m_semaphore(semaphore) {
+        m_semaphore.acquire();
+    }
+
+    ~Semaphore_guard() {
+        m_semaphore.release();
+    }
+
+    Semaphore_guard(const Semaphore_guard&) = delete;
+    Semaphore_guard& operator=(const Semaphore_guard&) = delete;
+
+private:
+    Semaphore& m_semaphore;
+};
@@ -0,0 +1,186 @@
+#include "common/Window_level.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WINDOW_LEVEL_SSE2
+#endif
+
+const float max_display_value{255.0f};
+const double min_window_slope_width{1e-3};
+const uint32_t opaque_alpha{0xff000000};
+// Values widened to 32 bits at a time, when there are too few to fill a table.
+const size_t widen_block_size{256};
+
+/** The window as output = value * scale + offset, before clamping. */
+struct Linear_window
+{
+    float scale;
+    float offset;
+};
+
+static Linear_window get_linear_window(double center, double width, bool inverse) {
+    // Widths of one and less make a threshold at center - 0.5.
+    const double slope_width = std::max(width - 1.0, min_window_slope_width);
+    const double scale = max_display_value / slope_width;
+    const double offset = (0.5 - (center - 0.5) / slope_width) * max_display_value;
+
+    if(inverse) {
+        return {static_cast<float>(-scale), static_cast<float>(max_display_value - offset)};
+    }
+    return {static_cast<float>(scale), static_cast<float>(offset)};
+}
+
+static uint8_t apply_scalar(int32_t value, const Linear_window& window) {
+    float output = static_cast<float>(value) * window.scale;
+    output += window.offset;
+    output = std::min(std::max(output, 0.0f), max_display_value);
+    return static_cast<uint8_t>(std::lrint(output));
+}
+
+static void apply_scalar(const int32_t* values, size_t count, const Linear_window& window, uint8_t* output) {
+    for(size_t i = 0; i < count; ++i) {
+        output[i] = apply_scalar(values[i], window);
+    }
+}
+
+static uint32_t to_rgb32(uint8_t gray) {
+    return opaque_alpha | gray * uint32_t{0x010101};
+}
+
+static void apply_rgb32_scalar(const int32_t* values, size_t count, const Linear_window& window, uint32_t* output) {
+    for(size_t i = 0; i < count; ++i) {
+        output[i] = to_rgb32(apply_scalar(values[i], window));
+    }
+}
+
+void Window_level::apply_scalar(const int32_t* values, size_t count, double center, double width, bool inverse, uint8_t* output) {
+    ::apply_scalar(values, count, get_linear_window(center, width, inverse), output);
+}
+
+#ifdef WINDOW_LEVEL_SSE2
+static __m128i apply_sse2(const int32_t* values, __m128 scale, __m128 offset, __m128 max_value) {
+    const __m128i integers = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+    __m128 floats = _mm_mul_ps(_mm_cvtepi32_ps(integers), scale);
+    floats = _mm_add_ps(floats, offset);
+    floats = _mm_min_ps(_mm_max_ps(floats, _mm_setzero_ps()), max_value);
+    return _mm_cvtps_epi32(floats);
+}
+
+class Sse2_window
+{
+public:
+    explicit Sse2_window(const Linear_window& window)
+        : m_scale(_mm_set1_ps(window.scale)),
+          m_offset(_mm_set1_ps(window.offset)),
+          m_max_value(_mm_set1_ps(max_display_value)) {}
+
+    /** Window 16 values, packed from four vectors of 32-bit results to one of bytes. */
+    __m128i apply_16(const int32_t* values) const {
+        const __m128i low = _mm_packs_epi32(apply_sse2(values, m_scale, m_offset, m_max_value),
+            apply_sse2(values + 4, m_scale, m_offset, m_max_value));
+        const __m128i high = _mm_packs_epi32(apply_sse2(values + 8, m_scale, m_offset, m_max_value),
+            apply_sse2(values + 12, m_scale, m_offset, m_max_value));
+        return _mm_packus_epi16(low, high);
+    }
+
+private:
+    __m128 m_scale;
+    __m128 m_offset;
+    __m128 m_max_value;
+};
+
+void Window_level::apply(const int32_t* values, size_t count, double center, double width, bool inverse, uint8_t* output) {
+    const Linear_window window = get_linear_window(center, width, inverse);
+    const Sse2_window sse2_window(window);
+    size_t i = 0;
+
+    for(; i + 16 <= count; i += 16) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i), sse2_window.apply_16(values + i));
+    }
+    ::apply_scalar(values + i, count - i, window, output + i);
+}
+
+void Window_level::apply_rgb32(const int32_t* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    const Linear_window window = get_linear_window(center, width, inverse);
+    const Sse2_window sse2_window(window);
+    const __m128i alpha = _mm_set1_epi32(static_cast<int>(opaque_alpha));
+    size_t i = 0;
+
+    for(; i + 16 <= count; i += 16) {
+        // Duplicating each byte twice gives the gray in all four bytes of a pixel.
+        const __m128i gray = sse2_window.apply_16(values + i);
+        const __m128i low = _mm_unpacklo_epi8(gray, gray);
+        const __m128i high = _mm_unpackhi_epi8(gray, gray);
+        auto pixels = reinterpret_cast<__m128i*>(output + i);
+        _mm_storeu_si128(pixels, _mm_or_si128(_mm_unpacklo_epi16(low, low), alpha));
+        _mm_storeu_si128(pixels + 1, _mm_or_si128(_mm_unpackhi_epi16(low, low), alpha));
+        _mm_storeu_si128(pixels + 2, _mm_or_si128(_mm_unpacklo_epi16(high, high), alpha));
+        _mm_storeu_si128(pixels + 3, _mm_or_si128(_mm_unpackhi_epi16(high, high), alpha));
+    }
+    apply_rgb32_scalar(values + i, count - i, window, output + i);
+}
+#else
+void Window_level::apply(const int32_t* values, size_t count, double center, double width, bool inverse, uint8_t* output) {
+    apply_scalar(values, count, center, width, inverse, output);
+}
+
+void Window_level::apply_rgb32(const int32_t* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    apply_rgb32_scalar(values, count, get_linear_window(center, width, inverse), output);
+}
+#endif
+
+template<typename T>
+static size_t get_table_size() {
+    return size_t{1} << (sizeof(T) * 8);
+}
+
+template<typename T>
+static void apply_rgb32_table(const T* values, size_t count, const Linear_window& window, uint32_t* output) {
+    const int32_t min_value = std::numeric_limits<T>::min();
+    std::vector<uint32_t> table(get_table_size<T>());
+
+    for(size_t i = 0; i < table.size(); ++i) {
+        table[i] = to_rgb32(apply_scalar(min_value + static_cast<int32_t>(i), window));
+    }
+    for(size_t i = 0; i < count; ++i) {
+        output[i] = table[static_cast<size_t>(values[i] - min_value)];
+    }
+}
+
+template<typename T>
+static void apply_rgb32_narrow(const T* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    /* A table costs one windowing per possible value, so fewer values, e.g. a
+    *  row of a tile, are widened and windowed directly. */
+    if(count >= get_table_size<T>()) {
+        apply_rgb32_table(values, count, get_linear_window(center, width, inverse), output);
+        return;
+    }
+    int32_t block[widen_block_size];
+
+    for(size_t i = 0; i < count; i += widen_block_size) {
+        const size_t block_count = std::min(widen_block_size, count - i);
+        std::copy_n(values + i, block_count, block);
+        Window_level::apply_rgb32(block, block_count, center, width, inverse, output + i);
+    }
+}
+
+void Window_level::apply_rgb32(const uint8_t* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    apply_rgb32_narrow(values, count, center, width, inverse, output);
+}
+
+void Window_level::apply_rgb32(const int8_t* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    apply_rgb32_narrow(values, count, center, width, inverse, output);
+}
+
+void Window_level::apply_rgb32(const uint16_t* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    apply_rgb32_narrow(values, count, center, width, inverse, output);
+}
+
+void Window_level::apply_rgb32(const int16_t* values, size_t count, double center, double width, bool inverse, uint32_t* output) {
+    apply_rgb32_narrow(values, count, center, width, inverse, output);
+}
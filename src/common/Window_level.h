@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+namespace Window_level
+{
+    /** Map modality values to 8-bit display values with the linear VOI function of
+     *  DICOM PS3.3 C.11.2.1.2.1. Inverse maps low values to bright pixels, as for
+     *  MONOCHROME1. Uses SSE2 where available. */
+    void apply(const int32_t* values, size_t count, double center, double width, bool inverse, uint8_t* output);
+    /** Same result as apply, without SIMD. */
+    void apply_scalar(const int32_t* values, size_t count, double center, double width, bool inverse, uint8_t* output);
+    /** As apply, but writes opaque gray pixels in the 0xffRRGGBB layout of
+     *  QImage::Format_RGB32, which the display can draw without converting. */
+    void apply_rgb32(const int32_t* values, size_t count, double center, double width, bool inverse, uint32_t* output);
+    /** As apply_rgb32, for values of up to 16 bits. Large images are windowed
+     *  through a table of the pixels of every value. */
+    void apply_rgb32(const uint8_t* values, size_t count, double center, double width, bool inverse, uint32_t* output);
+    void apply_rgb32(const int8_t* values, size_t count, double center, double width, bool inverse, uint32_t* output);
+    void apply_rgb32(const uint16_t* values, size_t count, double center, double width, bool inverse, uint32_t* output);
+    void apply_rgb32(const int16_t* values, size_t count, double center, double width, bool inverse, uint32_t* output);
+}
@@ -4,16 +4,34 @@
 #include "ui/main_view/Main_presenter.h"
 #include "ui/main_view/Main_view.h"
 
+#include <dcmtk/dcmdata/dcrledrg.h>
+#include <dcmtk/dcmjpeg/djdecode.h>
 #include <QApplication>
 #include <QIcon>
 #include <memory>
 #include <string>
 
+/** Registers the decoders for compressed pixel data. They are removed after
+ *  the presenters, whose threads may still be decoding, are destroyed. */
+struct Codec_registration
+{
+    Codec_registration() {
+        DJDecoderRegistration::registerCodecs();
+        DcmRLEDecoderRegistration::registerCodecs();
+    }
+
+    ~Codec_registration() {
+        DJDecoderRegistration::cleanup();
+        DcmRLEDecoderRegistration::cleanup();
+    }
+};
+
 int main(int argc, char** argv) {
     Log log(Log_level::info);
     log.add_logger(std::make_unique<Console_logger>());
 
     Log::info("dcmedit " + std::string(App_info::version));
+    Codec_registration codec_registration;
 
     QApplication app(argc, argv);
 	
@@ -0,0 +1,144 @@
+#include "models/Cine_player.h"
+
+#include "logging/Log.h"
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <algorithm>
+#include <exception>
+#include <string>
+#include <utility>
+
+const size_t cine_buffer_capacity{8};
+const double default_frames_per_second{25.0};
+const double max_frames_per_second{120.0};
+
+Cine_player::Cine_player(Frame_cache& frame_cache)
+    : m_frame_cache(frame_cache),
+      m_file(nullptr),
+      m_cache_generation(0),
+      m_first_frame(0),
+      m_frame_count(1),
+      m_frames_per_second(default_frames_per_second),
+      m_next_sequence(0),
+      m_dropped_count(0),
+      m_stopped(true) {}
+
+Cine_player::~Cine_player() {
+    stop();
+}
+
+void Cine_player::play(Dicom_file& file, unsigned long first_frame, unsigned long frame_count, double frames_per_second) {
+    stop();
+    m_file = &file;
+    m_path = file.get_path();
+    m_dataset = std::make_unique<Dataset_copy>(file);
+    m_cache_generation = m_frame_cache.get_generation();
+    m_first_frame = first_frame;
+    m_frame_count = std::max(frame_count, 1ul);
+    m_frames_per_second = std::clamp(frames_per_second, 1.0, max_frames_per_second);
+    m_start_time = std::chrono::steady_clock::now();
+    m_buffer.clear();
+    m_next_sequence = 0;
+    m_dropped_count = 0;
+    m_stopped = false;
+    m_thread = std::thread([this] {decode();});
+}
+
+void Cine_player::stop() {
+    if(!m_thread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_space_available.notify_all();
+    m_thread.join();
+    m_buffer.clear();
+    m_dataset.reset();
+    Log::debug("Cine stopped, " + std::to_string(m_dropped_count) + " frames dropped");
+}
+
+Cine_player::Frame Cine_player::take_due_frame() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t due_sequence = get_due_sequence();
+    Frame frame;
+
+    while(!m_buffer.empty() && m_buffer.front().sequence <= due_sequence) {
+        if(frame.frame != nullptr) {
+            ++m_dropped_count;
+        }
+        frame = std::move(m_buffer.front().frame);
+        m_buffer.pop_front();
+    }
+    if(frame.frame != nullptr) {
+        m_space_available.notify_one();
+        frame.frame = m_frame_cache.insert(*m_file, frame.index, frame.frame, m_cache_generation);
+    }
+    return frame;
+}
+
+size_t Cine_player::get_dropped_count() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_dropped_count;
+}
+
+double Cine_player::get_frame_rate(DcmItem& dataset) {
+    Sint32 rate = 0;
+
+    if(dataset.findAndGetSint32(DCM_CineRate, rate).good() && rate > 0) {
+        return rate;
+    }
+    if(dataset.findAndGetSint32(DCM_RecommendedDisplayFrameRate, rate).good() && rate > 0) {
+        return rate;
+    }
+    Float64 frame_time = 0.0;
+
+    if(dataset.findAndGetFloat64(DCM_FrameTime, frame_time).good() && frame_time > 0.0) {
+        return 1000.0 / frame_time;
+    }
+    return default_frames_per_second;
+}
+
+void Cine_player::decode() {
+    try {
+        DcmItem& dataset = m_dataset->get();
+
+        while(true) {
+            uint64_t sequence;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_space_available.wait(lock, [this] {return m_stopped || m_buffer.size() < cine_buffer_capacity;});
+
+                if(m_stopped) {
+                    return;
+                }
+                // Frames that are already late are skipped rather than decoded.
+                sequence = std::max(m_next_sequence, get_due_sequence());
+                m_dropped_count += sequence - m_next_sequence;
+                m_next_sequence = sequence + 1;
+            }
+            const unsigned long index = (m_first_frame + sequence) % m_frame_count;
+            std::shared_ptr<const Rendered_frame> frame = m_frame_cache.find(*m_file, index);
+
+            if(frame == nullptr) {
+                frame = std::make_shared<const Rendered_frame>(Frame_cache::render_frame(dataset, index));
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if(m_stopped) {
+                return;
+            }
+            m_buffer.push_back({sequence, {index, std::move(frame)}});
+        }
+    }
+    catch(const std::exception& e) {
+        Log::error("Failed to play file: " + m_path.string() +
+            "\nReason: " + std::string(e.what()));
+    }
+}
+
+uint64_t Cine_player::get_due_sequence() const {
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start_time;
+    return static_cast<uint64_t>(elapsed.count() * m_frames_per_second);
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "models/Dataset_copy.h"
+#include "models/Dicom_file.h"
+#include "models/Frame_cache.h"
+
+#include <dcmtk/dcmdata/dcitem.h>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+/** Plays the frames of a file at a fixed rate. A decoder thread renders the
+ *  upcoming frames into a bounded buffer, from its own copy of the dataset so
+ *  the file can be edited meanwhile. When decoding falls behind, late frames
+ *  are skipped, so playback keeps time instead of slowing down.
+ */
+class Cine_player
+{
+public:
+    struct Frame
+    {
+        unsigned long index = 0;
+        /** Null if no frame is due. */
+        std::shared_ptr<const Rendered_frame> frame;
+    };
+
+    explicit Cine_player(Frame_cache&);
+    ~Cine_player();
+    Cine_player(const Cine_player&) = delete;
+    Cine_player& operator=(const Cine_player&) = delete;
+
+    /** Start playback from first_frame, looping over frame_count frames. Playing
+     *  files are stopped first. Must be called on the thread that edits the file. */
+    void play(Dicom_file&, unsigned long first_frame, unsigned long frame_count, double frames_per_second);
+    void stop();
+    bool is_playing() const {return m_thread.joinable();}
+    /** Returns the latest frame that is due, and drops the frames before it.
+     *  Returns a null frame if the due frame is not decoded yet, without waiting
+     *  for it. Frames are added to the frame cache, so they are not decoded
+     *  again when playback stops. */
+    Frame take_due_frame();
+    /** Frames skipped since play, because they were decoded too late or not at all. */
+    size_t get_dropped_count() const;
+
+    /** Rate from Cine Rate, Recommended Display Frame Rate or Frame Time, or a default rate. */
+    static double get_frame_rate(DcmItem&);
+
+private:
+    struct Entry
+    {
+        uint64_t sequence;
+        Frame frame;
+    };
+
+    void decode();
+    uint64_t get_due_sequence() const;
+
+    Frame_cache& m_frame_cache;
+    const Dicom_file* m_file;
+    fs::path m_path;
+    std::unique_ptr<Dataset_copy> m_dataset;
+    uint64_t m_cache_generation;
+    unsigned long m_first_frame;
+    unsigned long m_frame_count;
+    double m_frames_per_second;
+    std::chrono::steady_clock::time_point m_start_time;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_space_available;
+    std::deque<Entry> m_buffer;
+    uint64_t m_next_sequence;
+    size_t m_dropped_count;
+    bool m_stopped;
+    std::thread m_thread;
+};
@@ -0,0 +1,28 @@
+#include "models/Dataset_copy.h"
+
+#include <stdexcept>
+
+Dataset_copy::Dataset_copy(Dicom_file& file)
+    : m_path(file.get_path()),
+      m_from_disk(!file.has_unsaved_changes()) {
+    // Values left on disk are copied as references, so the clone is cheap unless they were loaded.
+    if(!m_from_disk) {
+        m_dataset = std::make_unique<DcmDataset>(file.get_dataset());
+    }
+}
+
+DcmItem& Dataset_copy::get() {
+    if(m_dataset != nullptr) {
+        return *m_dataset;
+    }
+    if(m_file == nullptr) {
+        auto file = std::make_unique<DcmFileFormat>();
+        const OFCondition status = file->loadFile(m_path.string().c_str());
+
+        if(status.bad()) {
+            throw std::runtime_error(status.text());
+        }
+        m_file = std::move(file);
+    }
+    return *m_file->getDataset();
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include "models/Dicom_file.h"
+
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
+
+/** Private copy of the dataset of a file, for rendering on another thread while
+ *  the file is edited. A file without unsaved changes is loaded again from disk,
+ *  with its long values left on disk. Otherwise the dataset is cloned.
+ */
+class Dataset_copy
+{
+public:
+    /** Call on the thread that edits the file. */
+    explicit Dataset_copy(Dicom_file&);
+
+    /** Returns the copy, loading it on first use. Call on the thread that
+     *  renders. Throws if the file cannot be loaded. */
+    DcmItem& get();
+    /** True if the copy is loaded from disk rather than cloned. Loading is cheap
+     *  to repeat, so each thread can have its own copy. */
+    bool is_from_disk() const {return m_from_disk;}
+
+private:
+    fs::path m_path;
+    bool m_from_disk;
+    std::unique_ptr<DcmDataset> m_dataset;
+    std::unique_ptr<DcmFileFormat> m_file;
+};
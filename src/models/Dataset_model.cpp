@@ -3,8 +3,10 @@
 #include "common/Dicom_util.h"
 #include "logging/Log.h"
 
+#include <algorithm>
 #include <array>
 #include <cstdint>
+#include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmdata/dcelem.h>
 #include <dcmtk/dcmdata/dcistrmf.h>
 #include <dcmtk/dcmdata/dcitem.h>
@@ -102,6 +104,21 @@ static QVariant get_element_data(DcmElement& element, int column) {
     return data;
 }
 
+static bool is_image_attribute(const DcmTagKey& tag) {
+    // Group 0028 holds the image pixel, modality LUT, VOI LUT and palette attributes.
+    const Uint16 group = tag.getGroup();
+    return group == DCM_Rows.getGroup()
+        || group == DCM_PixelData.getGroup()
+        || tag == DCM_PresentationLUTShape
+        || tag == DCM_PresentationLUTSequence
+        || tag == DCM_SharedFunctionalGroupsSequence
+        || tag == DCM_PerFrameFunctionalGroupsSequence;
+}
+
+bool Dataset_change::affects_image() const {
+    return std::any_of(top_level_tags.begin(), top_level_tags.end(), is_image_attribute);
+}
+
 Dataset_model::Dataset_model(Dicom_files& files)
     : m_files(files) {
     setup_event_callbacks();
@@ -151,7 +168,13 @@ void Dataset_model::add_element(const QModelIndex& index, const std::string& tag
     layoutAboutToBeChanged({QPersistentModelIndex(index)});
     Dicom_util::set_element(tag_path, value, true, *object);
     layoutChanged({QPersistentModelIndex(index)});
-    mark_as_modified();
+
+    if(object->ident() == EVR_dataset) {
+        mark_as_modified(Dicom_util::get_top_level_tag(tag_path));
+    }
+    else {
+        mark_as_modified(*object);
+    }
 }
 
 void Dataset_model::add_item(const QModelIndex& index) {
@@ -164,7 +187,7 @@ void Dataset_model::add_item(const QModelIndex& index) {
     beginInsertRows(index, item_pos, item_pos);
     OFCondition status = sq->append(new DcmItem());
     endInsertRows();
-    mark_as_modified();
+    mark_as_modified(*sq);
 
     if(status.bad()) {
         throw std::runtime_error(status.text());
@@ -180,6 +203,12 @@ void Dataset_model::delete_index(const QModelIndex& index) {
     if(parent == nullptr) {
         throw std::runtime_error("failed to get parent");
     }
+    DcmObject* object = get_object(index);
+
+    if(object == nullptr) {
+        throw std::runtime_error("failed to get object");
+    }
+    const DcmTagKey top_level_tag = Dicom_util::get_top_level_tag(*object);
     const DcmEVR vr = parent->ident();
     const int row = index.row();
     bool bad_vr = false;
@@ -199,7 +228,7 @@ void Dataset_model::delete_index(const QModelIndex& index) {
         bad_vr = true;
     }
     endRemoveRows();
-    mark_as_modified();
+    mark_as_modified(top_level_tag);
 
     if(bad_vr) {
         throw std::runtime_error("Unexpected VR: " + std::to_string(vr));
@@ -224,7 +253,7 @@ void Dataset_model::set_value(const QModelIndex& index, const std::string& value
 
     OFCondition status = element->putString(value.c_str());
     dataChanged(index, index);
-    mark_as_modified();
+    mark_as_modified(*element);
 
     if(status.bad()) {
         throw std::runtime_error(status.text());
@@ -251,7 +280,7 @@ void Dataset_model::set_value_from_file(const QModelIndex& index, const std::str
     }
     OFCondition status = element->createValueFromTempFile(file_stream.newFactory(), file_size, EBO_LittleEndian);
     dataChanged(index, index);
-    mark_as_modified();
+    mark_as_modified(*element);
 
     if(status.bad()) {
         throw std::runtime_error(status.text());
@@ -441,11 +470,19 @@ QVariant Dataset_model::headerData(int section, Qt::Orientation orientation, int
 void Dataset_model::reset_model() {
     beginResetModel();
     endResetModel();
-    dataset_changed();
+    Dataset_change change;
+    change.reset = true;
+    dataset_changed(change);
     Log::debug("Dataset model was reset");
 }
 
-void Dataset_model::mark_as_modified() {
-    m_files.get_current_file()->set_unsaved_changes(true);
-    dataset_changed();
+void Dataset_model::mark_as_modified(const DcmTagKey& top_level_tag) {
+    m_files.get_current_file()->mark_modified(top_level_tag);
+    Dataset_change change;
+    change.top_level_tags.push_back(top_level_tag);
+    dataset_changed(change);
+}
+
+void Dataset_model::mark_as_modified(DcmObject& changed_object) {
+    mark_as_modified(Dicom_util::get_top_level_tag(changed_object));
 }
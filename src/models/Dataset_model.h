@@ -1,9 +1,22 @@
 #pragma once
 #include "models/Dicom_files.h"
 
+#include <dcmtk/dcmdata/dctagkey.h>
 #include <dcmtk/dcmdata/dcvr.h>
 #include <eventi/Event.h>
 #include <QAbstractItemModel>
+#include <vector>
+
+/** Describes an edit by the top-level elements it changed. After a reset,
+ *  for example when another file is set as current, anything may have changed. */
+struct Dataset_change
+{
+    bool reset = false;
+    std::vector<DcmTagKey> top_level_tags;
+
+    /** True if an attribute that changes how the pixel data is decoded or displayed was edited. */
+    bool affects_image() const;
+};
 
 class Dataset_model : public QAbstractItemModel
 {
@@ -11,8 +24,9 @@ class Dataset_model : public QAbstractItemModel
 public:
     Dataset_model(Dicom_files&);
 
-    eventi::Event<> dataset_changed;
+    eventi::Event<const Dataset_change&> dataset_changed;
 
+    Dicom_file* get_file() const {return m_files.get_current_file();}
     DcmItem* get_dataset() const;
     DcmObject* get_object(const QModelIndex&) const;
     DcmEVR get_vr(const QModelIndex&) const;
@@ -36,7 +50,8 @@ private:
     void setup_event_callbacks();
 
     void reset_model();
-    void mark_as_modified();
+    void mark_as_modified(const DcmTagKey& top_level_tag);
+    void mark_as_modified(DcmObject& changed_object);
 
     Dicom_files& m_files;
 };
\ No newline at end of file
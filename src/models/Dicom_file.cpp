@@ -1,30 +1,137 @@
 #include "Dicom_file.h"
 
+#include "common/Element_scanner.h"
+#include "common/File_util.h"
 #include "logging/Log.h"
 
 #include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcelem.h>
+#include <dcmtk/dcmdata/dcistrmf.h>
 #include <dcmtk/dcmdata/dcmetinf.h>
+#include <dcmtk/dcmdata/dcostrmb.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmdata/dcstack.h>
 #include <dcmtk/dcmdata/dcuid.h>
 #include <dcmtk/dcmdata/dcxfer.h>
+#include <algorithm>
+#include <exception>
+#include <fstream>
 #include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
 
-Dicom_file::Dicom_file(const fs::path& path)
+// Rough cost of an element's object, tag and list node.
+const size_t element_overhead{128};
+// Tag and length of an item of encapsulated pixel data.
+const uint64_t item_header_size{8};
+
+static std::string get_string(DcmItem& item, const DcmTagKey& tag) {
+    const char* value = nullptr;
+    item.findAndGetString(tag, value);
+    return value != nullptr ? value : "";
+}
+
+/** Encode the element with its tag and length, as it would be written in a file. */
+static std::vector<char> encode_element(DcmElement& element, E_TransferSyntax transfer_syntax, E_EncodingType encoding) {
+    std::vector<char> data(element.calcElementLength(transfer_syntax, encoding));
+    DcmOutputBufferStream stream(data.data(), data.size());
+    element.transferInit();
+    OFCondition status = element.write(stream, transfer_syntax, encoding, nullptr);
+    element.transferEnd();
+
+    if(status.bad()) {
+        throw std::runtime_error(status.text());
+    }
+    void* buffer_data = nullptr;
+    offile_off_t length = 0;
+    stream.flush();
+    stream.flushBuffer(buffer_data, length);
+    data.resize(static_cast<size_t>(length));
+    return data;
+}
+
+static void put_string(DcmItem& item, const DcmTagKey& tag, const std::string& value) {
+    if(!value.empty()) {
+        item.putAndInsertString(tag, value.c_str());
+    }
+}
+
+Dicom_file::Dicom_file(const fs::path& path, const Load_options& options)
     : m_path(path),
-      m_unsaved_changes(false) {
+      m_file(std::make_unique<DcmFileFormat>()),
+      m_max_read_length(options.max_read_length),
+      m_unsaved_changes(false),
+      m_untracked_changes(false),
+      m_fully_loaded(!options.header_only),
+      m_summary_only(false),
+      m_replace_in_place(false) {
     if(!OFStandard::fileExists(path.c_str())) {
         throw std::runtime_error("file not found");
     }
-	OFCondition status = m_file.loadFile(path.c_str());
+    OFCondition status;
+
+    if(options.header_only) {
+        status = m_file->loadFileUntilTag(path.c_str(), EXS_Unknown, EGL_noChange,
+            m_max_read_length, ERM_autoDetect, options.stop_tag);
+    }
+    else {
+        status = m_file->loadFile(path.c_str(), EXS_Unknown, EGL_noChange, m_max_read_length);
+    }
+    if(status.bad()) {
+        throw std::runtime_error(status.text());
+    }
+    Log::debug("Loaded file: " + m_path.string());
+}
 
-	if (status.bad()) {
-		throw std::runtime_error(status.text());
-	}
-	Log::debug("Loaded file: " + m_path.string());
+Dicom_file::Dicom_file(const fs::path& path, const File_summary& summary, const Load_options& options)
+    : m_path(path),
+      m_file(std::make_unique<DcmFileFormat>()),
+      m_max_read_length(options.max_read_length),
+      m_unsaved_changes(false),
+      m_untracked_changes(false),
+      m_fully_loaded(false),
+      m_summary_only(true),
+      m_replace_in_place(false) {
+    set_summary(summary);
+}
+
+void Dicom_file::set_summary(const File_summary& summary) {
+    DcmMetaInfo& meta_info = *m_file->getMetaInfo();
+    put_string(meta_info, DCM_MediaStorageSOPClassUID, summary.sop_class_uid);
+    put_string(meta_info, DCM_TransferSyntaxUID, summary.transfer_syntax_uid);
+
+    DcmDataset& dataset = *m_file->getDataset();
+    put_string(dataset, DCM_PatientID, summary.patient_id);
+    put_string(dataset, DCM_PatientName, summary.patient_name);
+    put_string(dataset, DCM_StudyInstanceUID, summary.study_instance_uid);
+    put_string(dataset, DCM_StudyDescription, summary.study_description);
+    put_string(dataset, DCM_SeriesInstanceUID, summary.series_instance_uid);
+    put_string(dataset, DCM_SeriesDescription, summary.series_description);
+    put_string(dataset, DCM_SOPClassUID, summary.sop_class_uid);
+    put_string(dataset, DCM_InstanceNumber, summary.instance_number);
+    put_string(dataset, DCM_ImagePositionPatient, summary.image_position_patient);
+    put_string(dataset, DCM_ImageOrientationPatient, summary.image_orientation_patient);
+}
 
+void Dicom_file::set_unsaved_changes(bool value) {
+    m_unsaved_changes = value;
+    m_untracked_changes = value;
+
+    if(!value) {
+        m_modified_tags.clear();
+    }
+}
+
+void Dicom_file::mark_modified(const DcmTagKey& top_level_tag) {
+    m_unsaved_changes = true;
+    m_modified_tags.insert(top_level_tag);
 }
 
 bool Dicom_file::is_dicomdir() {
-    DcmMetaInfo* meta_info = m_file.getMetaInfo();
+    DcmMetaInfo* meta_info = m_file->getMetaInfo();
 
     if(meta_info == nullptr) {
         return false;
@@ -36,24 +143,434 @@ bool Dicom_file::is_dicomdir() {
     return media_storage == UID_MediaStorageDirectoryStorage;
 }
 
+File_summary Dicom_file::get_summary() {
+    DcmMetaInfo& meta_info = *m_file->getMetaInfo();
+    DcmDataset& dataset = *m_file->getDataset();
+    File_summary summary;
+    summary.patient_id = get_string(dataset, DCM_PatientID);
+    summary.patient_name = get_string(dataset, DCM_PatientName);
+    summary.study_instance_uid = get_string(dataset, DCM_StudyInstanceUID);
+    summary.study_description = get_string(dataset, DCM_StudyDescription);
+    summary.series_instance_uid = get_string(dataset, DCM_SeriesInstanceUID);
+    summary.series_description = get_string(dataset, DCM_SeriesDescription);
+    summary.sop_class_uid = get_string(meta_info, DCM_MediaStorageSOPClassUID);
+
+    if(summary.sop_class_uid.empty()) {
+        summary.sop_class_uid = get_string(dataset, DCM_SOPClassUID);
+    }
+    summary.transfer_syntax_uid = get_string(meta_info, DCM_TransferSyntaxUID);
+
+    if(summary.transfer_syntax_uid.empty()) {
+        summary.transfer_syntax_uid = DcmXfer(dataset.getOriginalXfer()).getXferID();
+    }
+    summary.instance_number = get_string(dataset, DCM_InstanceNumber);
+    summary.image_position_patient = get_string(dataset, DCM_ImagePositionPatient);
+    summary.image_orientation_patient = get_string(dataset, DCM_ImageOrientationPatient);
+    return summary;
+}
+
+void Dicom_file::load_fully() {
+    if(m_fully_loaded) {
+        return;
+    }
+    if(m_unsaved_changes) {
+        throw std::logic_error("file was modified before it was fully loaded");
+    }
+    load_fully(parse_file(m_path, m_max_read_length));
+}
+
+std::unique_ptr<DcmFileFormat> Dicom_file::parse_file(const fs::path& path, Uint32 max_read_length) {
+    auto file = std::make_unique<DcmFileFormat>();
+    OFCondition status = file->loadFile(path.c_str(), EXS_Unknown, EGL_noChange, max_read_length);
+
+    if(status.bad()) {
+        throw std::runtime_error(status.text());
+    }
+    return file;
+}
+
+void Dicom_file::load_fully(std::unique_ptr<DcmFileFormat> file) {
+    if(m_fully_loaded) {
+        return;
+    }
+    if(m_unsaved_changes) {
+        throw std::logic_error("file was modified before it was fully loaded");
+    }
+    m_file = std::move(file);
+    m_fully_loaded = true;
+    m_summary_only = false;
+    Log::debug("Fully loaded file: " + m_path.string());
+}
+
+void Dicom_file::unload() {
+    if(m_summary_only) {
+        return;
+    }
+    if(m_unsaved_changes) {
+        throw std::logic_error("file has unsaved changes");
+    }
+    const File_summary summary = get_summary();
+    m_file = std::make_unique<DcmFileFormat>();
+    set_summary(summary);
+    m_fully_loaded = false;
+    m_summary_only = true;
+    Log::debug("Unloaded file: " + m_path.string());
+}
+
+size_t Dicom_file::get_memory_usage() {
+    size_t size = 0;
+    DcmStack stack;
+
+    while(m_file->nextObject(stack, OFTrue).good()) {
+        DcmObject* object = stack.top();
+        size += element_overhead;
+
+        if(object->isLeaf() && static_cast<DcmElement*>(object)->valueLoaded()) {
+            size += object->getLength();
+        }
+    }
+    return size;
+}
+
 void Dicom_file::save_file() {
     save_file_as(m_path);
 }
 
 void Dicom_file::save_file_as(const fs::path& path) {
-    OFCondition status = m_file.getDataset()->loadAllDataIntoMemory();
+    if(path == m_path && try_patch_file()) {
+        File_util::sync_file(path);
+        return;
+    }
+    if(!try_stream_file(path)) {
+        stage_full_file(path);
+    }
+    try {
+        File_util::sync_file(get_staged_temp_path());
+    }
+    catch(const std::exception&) {
+        discard_staged_file();
+        throw;
+    }
+    commit_staged_file();
+    File_util::sync_directory(path.parent_path());
+}
+
+void Dicom_file::stage_full_file(const fs::path& path) {
+    load_fully();
+    OFCondition status = m_file->getDataset()->loadAllDataIntoMemory();
+    const fs::path temp_path = begin_staging(path);
 
     if(status.good()) {
-        E_TransferSyntax original_transfer = m_file.getDataset()->getOriginalXfer();
-        E_TransferSyntax new_transfer = original_transfer != EXS_Unknown ? original_transfer : EXS_LittleEndianExplicit;
-        status = m_file.saveFile(path.c_str(), new_transfer);
+        status = m_file->saveFile(temp_path.c_str(), get_save_transfer_syntax());
+    }
+    try {
+        if(status.bad()) {
+            throw std::runtime_error(status.text());
+        }
+        end_staging();
+    }
+    catch(const std::exception&) {
+        discard_staged_file();
+        throw;
+    }
+}
+
+fs::path Dicom_file::begin_staging(const fs::path& path) {
+    discard_staged_file();
+    // Renaming over a symbolic link would replace the link instead of the file it points to.
+    fs::path target = File_util::resolve_symlinks(path);
+    m_staged_temp_path = File_util::create_temp_file(target);
+    m_staged_target = std::move(target);
+    m_staged_path = path;
+    return m_staged_temp_path;
+}
+
+void Dicom_file::end_staging() {
+    std::error_code error;
+
+    if(!fs::exists(m_staged_target, error)) {
+        return;
+    }
+    // Renaming would split hard links, and leave the target owned by this process
+    // if its owner could not be copied.
+    m_replace_in_place = fs::hard_link_count(m_staged_target) > 1
+        || !File_util::copy_attributes(m_staged_target, get_staged_temp_path());
+}
+
+fs::path Dicom_file::get_staged_temp_path() const {
+    return m_staged_temp_path;
+}
+
+void Dicom_file::commit_staged_file() {
+    if(!has_staged_file()) {
+        throw std::logic_error("no staged file to commit");
+    }
+    try {
+        if(m_replace_in_place) {
+            File_util::replace_contents(get_staged_temp_path(), m_staged_target);
+            fs::remove(get_staged_temp_path());
+            Log::debug("Saved file in place to keep its links and attributes: " + m_staged_path.string());
+        }
+        else {
+            fs::rename(get_staged_temp_path(), m_staged_target);
+        }
+    }
+    catch(const std::exception&) {
+        discard_staged_file();
+        throw;
+    }
+    for(const Staged_value& value : m_staged_values) {
+        auto factory = new DcmInputFileStreamFactory(m_staged_path.c_str(), static_cast<offile_off_t>(value.offset));
+        OFCondition status = value.element->createValueFromTempFile(factory, value.length, EBO_LittleEndian);
+
+        if(status.bad()) {
+            Log::error("Failed to read value from saved file: " + m_staged_path.string() +
+                "\nReason: " + std::string(status.text()));
+        }
+    }
+    m_path = m_staged_path;
+    m_staged_path.clear();
+    m_staged_target.clear();
+    m_staged_temp_path.clear();
+    m_staged_values.clear();
+    m_replace_in_place = false;
+    set_unsaved_changes(false);
+    Log::debug("Saved file: " + m_path.string());
+}
+
+void Dicom_file::discard_staged_file() {
+    if(!has_staged_file()) {
+        return;
+    }
+    std::error_code error;
+    fs::remove(get_staged_temp_path(), error);
+    m_staged_path.clear();
+    m_staged_target.clear();
+    m_staged_temp_path.clear();
+    m_staged_values.clear();
+    m_replace_in_place = false;
+}
+
+bool Dicom_file::try_patch_file() {
+    if(!m_unsaved_changes || m_untracked_changes || !m_fully_loaded) {
+        return false;
+    }
+    try {
+        return patch_file();
+    }
+    catch(const std::exception& e) {
+        Log::warning("Failed to patch file: " + m_path.string() + "\nReason: " + std::string(e.what()));
+        return false;
+    }
+}
+
+bool Dicom_file::patch_file() {
+    // These values are copied into the meta header when the file is written.
+    if(m_modified_tags.count(DCM_SOPClassUID) > 0 || m_modified_tags.count(DCM_SOPInstanceUID) > 0) {
+        return false;
+    }
+    const File_layout layout = Element_scanner::scan_file(m_path);
+    DcmDataset& dataset = get_dataset();
+
+    if(layout.transfer_syntax != get_save_transfer_syntax() || layout.dataset_elements.size() != dataset.card()) {
+        return false;
+    }
+    const bool explicit_vr = DcmXfer(layout.transfer_syntax).isExplicitVR();
+    std::vector<std::pair<uint64_t, std::vector<char>>> patches;
+    std::ifstream source(m_path, std::ios_base::binary);
+
+    for(unsigned long i = 0; i < dataset.card(); ++i) {
+        DcmElement& element = *dataset.getElement(i);
+        const Element_location& location = layout.dataset_elements[i];
+
+        if(element.getTag() != location.tag) {
+            return false;
+        }
+        if(m_modified_tags.count(location.tag) == 0) {
+            continue;
+        }
+        const E_EncodingType encoding = location.undefined_length ? EET_UndefinedLength : EET_ExplicitLength;
+        std::vector<char> data = encode_element(element, layout.transfer_syntax, encoding);
+
+        if(data.size() != location.size) {
+            return false;
+        }
+        if(explicit_vr) {
+            char vr[2];
+            source.seekg(static_cast<std::streamoff>(location.offset + 4));
+            source.read(vr, 2);
+
+            if(!source || vr[0] != data[4] || vr[1] != data[5]) {
+                return false;
+            }
+        }
+        patches.emplace_back(location.offset, std::move(data));
+    }
+    if(patches.size() != m_modified_tags.size()) {
+        return false;
+    }
+    source.close();
+    std::fstream file(m_path, std::ios_base::binary | std::ios_base::in | std::ios_base::out);
+
+    for(const auto& [offset, data] : patches) {
+        file.seekp(static_cast<std::streamoff>(offset));
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    file.flush();
+
+    for(const auto& [offset, data] : patches) {
+        std::vector<char> written(data.size());
+        file.seekg(static_cast<std::streamoff>(offset));
+        file.read(written.data(), static_cast<std::streamsize>(written.size()));
+
+        if(!file || written != data) {
+            throw std::runtime_error("patched values could not be read back");
+        }
+    }
+    set_unsaved_changes(false);
+    Log::debug("Patched " + std::to_string(patches.size()) + " elements in file: " + m_path.string());
+    return true;
+}
+
+bool Dicom_file::try_stream_file(const fs::path& path) {
+    if(m_untracked_changes || !m_fully_loaded) {
+        return false;
+    }
+    try {
+        return stream_file(path);
+    }
+    catch(const std::exception& e) {
+        Log::warning("Failed to save file by copying pixel data: " + path.string() +
+            "\nReason: " + std::string(e.what()));
+        return false;
+    }
+}
+
+/** Values of the tail that were left on disk, with their offsets in the current file. */
+using On_disk_values = std::vector<std::pair<DcmElement*, uint64_t>>;
+
+/** Add the fragments of encapsulated pixel data that were left on disk. Returns
+ *  false, and adds nothing, if the fragments do not match the items in the file. */
+static bool add_on_disk_fragments(DcmElement& element, const Element_location& location,
+    E_TransferSyntax transfer_syntax, On_disk_values& values) {
+    auto pixel_data = dynamic_cast<DcmPixelData*>(&element);
+    DcmPixelSequence* sequence = nullptr;
+
+    if(pixel_data == nullptr || pixel_data->getEncapsulatedRepresentation(transfer_syntax, nullptr, sequence).bad()
+        || sequence == nullptr || sequence->card() != location.items.size()) {
+        return false;
+    }
+    On_disk_values fragments;
+
+    for(unsigned long i = 0; i < sequence->card(); ++i) {
+        DcmPixelItem* fragment = nullptr;
+        const Element_location& item = location.items[i];
+
+        if(sequence->getItem(fragment, i).bad() || item.size != item_header_size + fragment->getLength()) {
+            return false;
+        }
+        if(!fragment->valueLoaded()) {
+            fragments.emplace_back(fragment, item.offset + item_header_size);
+        }
+    }
+    values.insert(values.end(), fragments.begin(), fragments.end());
+    return true;
+}
+
+bool Dicom_file::stream_file(const fs::path& path) {
+    for(const DcmTagKey& tag : m_modified_tags) {
+        if(!(tag < DCM_PixelData)) {
+            return false;
+        }
+    }
+    DcmDataset& dataset = get_dataset();
+
+    // The group length would be recalculated without the pixel data.
+    if(dataset.tagExists(DcmTagKey(DCM_PixelData.getGroup(), 0x0000))) {
+        return false;
+    }
+    const File_layout layout = Element_scanner::scan_file(m_path);
+
+    if(layout.transfer_syntax != get_save_transfer_syntax()) {
+        return false;
+    }
+    auto tail_begin = std::find_if(layout.dataset_elements.begin(), layout.dataset_elements.end(),
+        [] (const Element_location& location) {return location.tag == DCM_PixelData;});
+    const std::vector<Element_location> tail(tail_begin, layout.dataset_elements.end());
+    unsigned long first_tail_index = 0;
+
+    while(first_tail_index < dataset.card() && dataset.getElement(first_tail_index)->getTag() < DCM_PixelData) {
+        ++first_tail_index;
+    }
+    if(tail.empty() || dataset.card() - first_tail_index != tail.size()) {
+        return false;
+    }
+    // Values that are left on disk, including fragments of encapsulated pixel data, are
+    // bound to the new file when it is committed. Other values are read now, since the
+    // current file may be replaced.
+    On_disk_values on_disk_values;
+    OFCondition status;
+
+    for(unsigned long i = 0; i < dataset.card() && status.good(); ++i) {
+        DcmElement& element = *dataset.getElement(i);
+
+        if(i < first_tail_index) {
+            status = element.loadAllDataIntoMemory();
+            continue;
+        }
+        const Element_location& location = tail[i - first_tail_index];
+
+        if(element.getTag() != location.tag) {
+            return false;
+        }
+        if(element.isLeaf() && !element.valueLoaded() && !location.undefined_length) {
+            on_disk_values.emplace_back(&element, location.offset + location.size - element.getLength());
+        }
+        else if(location.items.empty()
+            || !add_on_disk_fragments(element, location, layout.transfer_syntax, on_disk_values)) {
+            status = element.loadAllDataIntoMemory();
+        }
     }
     if(status.bad()) {
         throw std::runtime_error(status.text());
     }
-    m_path = path;
-    m_unsaved_changes = false;
-    Log::debug("Saved file: " + path.string());
+    const fs::path temp_path = begin_staging(path);
+    std::vector<DcmElement*> tail_elements;
+
+    while(dataset.card() > first_tail_index) {
+        tail_elements.push_back(dataset.remove(first_tail_index));
+    }
+    status = m_file->saveFile(temp_path.c_str(), layout.transfer_syntax);
+
+    for(DcmElement* element : tail_elements) {
+        dataset.insert(element);
+    }
+    const uint64_t tail_offset = tail.front().offset;
+    uint64_t header_size = 0;
+
+    try {
+        if(status.bad()) {
+            throw std::runtime_error(status.text());
+        }
+        header_size = fs::file_size(temp_path);
+        File_util::append_file_range(m_path, tail_offset, layout.file_size - tail_offset, temp_path);
+        end_staging();
+    }
+    catch(const std::exception&) {
+        discard_staged_file();
+        throw;
+    }
+    for(const auto& [element, offset] : on_disk_values) {
+        m_staged_values.push_back({element, header_size + offset - tail_offset, element->getLength()});
+    }
+    Log::debug("Copied " + std::to_string(layout.file_size - tail_offset) +
+        " bytes of pixel data to: " + temp_path.string());
+    return true;
+}
+
+E_TransferSyntax Dicom_file::get_save_transfer_syntax() {
+    const E_TransferSyntax original_transfer = m_file->getDataset()->getOriginalXfer();
+    return original_transfer != EXS_Unknown ? original_transfer : EXS_LittleEndianExplicit;
 }
 
 void Dicom_file::create_new_file(const fs::path& path) {
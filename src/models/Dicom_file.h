@@ -1,27 +1,120 @@
 #pragma once
+#include "models/File_summary.h"
+
+#include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dctagkey.h>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
+#include <memory>
+#include <set>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+struct Load_options
+{
+    /** Only parse the file up to stop_tag. The rest is loaded by Dicom_file::load_fully. */
+    bool header_only = false;
+    DcmTagKey stop_tag = DCM_PixelData;
+    /** Values longer than this are left on disk and read when they are accessed. */
+    Uint32 max_read_length = DCM_MaxReadLength;
+};
+
 class Dicom_file
 {
 public:
-    Dicom_file(const fs::path&);
+    Dicom_file(const fs::path&, const Load_options& = Load_options());
+    /** Create a file that only contains the summary. The file is parsed by load_fully. */
+    Dicom_file(const fs::path&, const File_summary&, const Load_options& = Load_options());
 
-    DcmDataset& get_dataset() {return *m_file.getDataset();}
+    DcmDataset& get_dataset() {return *m_file->getDataset();}
     fs::path get_path() {return m_path;}
     bool has_unsaved_changes() {return m_unsaved_changes;}
-    void set_unsaved_changes(bool value) {m_unsaved_changes = value;}
+    /** Setting unsaved changes without mark_modified makes the next save rewrite the whole file. */
+    void set_unsaved_changes(bool);
+    /** Record a change to a top-level element, or to anything nested in it. If only
+     *  values change and keep their encoded length, saving patches the file in place. */
+    void mark_modified(const DcmTagKey& top_level_tag);
     bool is_dicomdir();
+    File_summary get_summary();
+
+    /** False if only the header was parsed. */
+    bool is_fully_loaded() const {return m_fully_loaded;}
+    /** True if the dataset only contains the summary. */
+    bool is_summary_only() const {return m_summary_only;}
+    /** Parse the whole file. The dataset is replaced, so pointers into it become invalid. */
+    void load_fully();
+    /** As load_fully, with a file that was parsed by parse_file, e.g. on another thread. */
+    void load_fully(std::unique_ptr<DcmFileFormat>);
+    /** Parse a whole file as load_fully does. Can be called from any thread. */
+    static std::unique_ptr<DcmFileFormat> parse_file(const fs::path&, Uint32 max_read_length);
+    Uint32 get_max_read_length() const {return m_max_read_length;}
+    /** Replace the dataset with its summary to free memory. Throws if the file has unsaved changes. */
+    void unload();
+    /** Estimate of the memory used by the values that are loaded. */
+    size_t get_memory_usage();
 
     void save_file();
+    /** Save through a temporary file that replaces the target once it is flushed
+     *  to disk, so a crash leaves either the old or the new file. There are two
+     *  exceptions. A file patched by try_patch_file is written in place. A symbolic
+     *  link is followed, so the file it points to is replaced. A target
+     *  with several hard links, or with an owner or access control list that cannot
+     *  be copied, is overwritten in place to keep them. */
     void save_file_as(const fs::path&);
+    /** Stage the whole file, with all values read into memory first. */
+    void stage_full_file(const fs::path&);
+    /** Save by writing only the changed values over the existing file. Returns
+     *  false, and saves nothing, if the changes alter the layout of the file. This
+     *  is not atomic. A crash while patching can leave some values old, but the
+     *  file stays readable, since the values keep their encoded length. */
+    bool try_patch_file();
+    /** Stage a file with the elements before the pixel data encoded and the pixel data,
+     *  and the elements after it, copied unchanged from the current file. Values that were
+     *  left on disk stay there. Returns false, and stages nothing, if they were modified. */
+    bool try_stream_file(const fs::path&);
+
+    /** A staged file is written to a temporary file next to its target, with the
+     *  target's attributes. The target is only replaced by commit_staged_file. */
+    bool has_staged_file() const {return !m_staged_path.empty();}
+    fs::path get_staged_temp_path() const;
+    void commit_staged_file();
+    void discard_staged_file();
 
     static void create_new_file(const fs::path&);
 
 private:
+    void set_summary(const File_summary&);
+    E_TransferSyntax get_save_transfer_syntax();
+    bool patch_file();
+    bool stream_file(const fs::path&);
+    fs::path begin_staging(const fs::path&);
+    void end_staging();
+
     fs::path m_path;
-    DcmFileFormat m_file;
+    std::unique_ptr<DcmFileFormat> m_file;
+    Uint32 m_max_read_length;
     bool m_unsaved_changes;
+    bool m_untracked_changes;
+    std::set<DcmTagKey> m_modified_tags;
+    bool m_fully_loaded;
+    bool m_summary_only;
+
+    struct Staged_value
+    {
+        DcmElement* element;
+        uint64_t offset;
+        Uint32 length;
+    };
+    fs::path m_staged_path;
+    /** The staged path with symbolic links resolved, which the staged file replaces. */
+    fs::path m_staged_target;
+    /** Uniquely named file next to the target, which the staged file is written to. */
+    fs::path m_staged_temp_path;
+    /** Set if the staged file is copied into the target instead of renamed. */
+    bool m_replace_in_place;
+    /** Values left on disk, with their location in the staged file. */
+    std::vector<Staged_value> m_staged_values;
 };
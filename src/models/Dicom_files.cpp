@@ -1,12 +1,26 @@
 #include "models/Dicom_files.h"
 
 #include "Dicom_file.h"
+#include "common/Semaphore.h"
+#include "logging/Log.h"
 
 #include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <set>
 #include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+const size_t default_memory_budget{size_t{2} * 1024 * 1024 * 1024};
 
 Dicom_files::Dicom_files()
-    : m_current_file(nullptr) {}
+    : m_current_file(nullptr),
+      m_residency(default_memory_budget) {
+    m_load_options.header_only = true;
+}
 
 void Dicom_files::create_new_file(const fs::path& path) {
     Dicom_file::create_new_file(path);
@@ -14,23 +28,40 @@ void Dicom_files::create_new_file(const fs::path& path) {
 }
 
 void Dicom_files::open_file(const fs::path& path) {
-    auto replace_file = std::find_if(m_files.begin(), m_files.end(), [&](auto& file) {
-        return file->get_path() == path;
-    });
+    Dicom_file* replace_file = find_file(path);
 
-    if(replace_file != m_files.end() && (*replace_file)->has_unsaved_changes()) {
+    if(replace_file != nullptr && replace_file->has_unsaved_changes()) {
         throw std::runtime_error("file is already open and has unsaved changes");
     }
-    auto file = std::make_unique<Dicom_file>(path);
+    Dicom_file* file = add_file(std::make_unique<Dicom_file>(path, m_load_options));
+    set_current_file(file);
+}
+
+Dicom_file* Dicom_files::add_file(std::unique_ptr<Dicom_file> file) {
+    const Index_keys keys = make_index_keys(file->get_path());
+    return add_file(std::move(file), keys);
+}
+
+Dicom_file* Dicom_files::add_file(std::unique_ptr<Dicom_file> file, const Index_keys& keys) {
+    Dicom_file* replace_file = find_file(keys);
 
+    if(replace_file != nullptr && replace_file->has_unsaved_changes()) {
+        throw std::runtime_error("file is already open and has unsaved changes");
+    }
     if(file->is_dicomdir()) {
         throw std::runtime_error("DICOMDIR is not supported");
     }
-    if(replace_file != m_files.end()) {
-        m_files.erase(replace_file);
+    if(replace_file != nullptr) {
+        if(replace_file == m_current_file) {
+            m_current_file = nullptr;
+        }
+        remove_file(replace_file);
     }
     m_files.push_back(std::move(file));
-    set_current_file(m_files.back().get());
+    Dicom_file* added_file = m_files.back().get();
+    add_to_index(added_file, keys);
+    m_residency.touch(*added_file, m_current_file);
+    return added_file;
 }
 
 bool Dicom_files::has_unsaved_changes() const {
@@ -40,48 +71,246 @@ bool Dicom_files::has_unsaved_changes() const {
 }
 
 void Dicom_files::clear_all_files() {
+    for(auto& file : m_files) {
+        file_removed(file.get());
+    }
     m_files.clear();
+    m_path_index.clear();
+    m_identity_index.clear();
+    m_index_keys.clear();
+    m_residency.clear();
     set_current_file(nullptr);
 }
 
 void Dicom_files::save_current_file_as(const fs::path& new_path) {
-    bool same_path = m_current_file->get_path() == new_path;
-    auto replace_file = std::find_if(m_files.begin(), m_files.end(), [&](auto& file) {
-        return !same_path && file->get_path() == new_path;
-    });
+    Dicom_file* replace_file = find_file(new_path);
 
-    if(replace_file != m_files.end() && (*replace_file)->has_unsaved_changes()) {
+    if(replace_file == m_current_file) {
+        replace_file = nullptr;
+    }
+    if(replace_file != nullptr && replace_file->has_unsaved_changes()) {
         throw std::runtime_error("file is already open and has unsaved changes");
     }
     m_current_file->save_file_as(new_path);
 
-    if(replace_file != m_files.end()) {
-        m_files.erase(replace_file);
+    if(replace_file != nullptr) {
+        remove_file(replace_file);
     }
+    remove_from_index(m_current_file);
+    add_to_index(m_current_file, make_index_keys(new_path));
     file_saved();
 }
 
-bool Dicom_files::save_all_files(Progress_token& progress_token) {
-    bool ok = true;
-    progress_token.set_max_progress(static_cast<int>(m_files.size()));
+Save_result Dicom_files::save_all_files(Progress_token& progress_token) {
+    Save_result result;
+    std::vector<Dicom_file*> dirty_files;
 
     for(auto& file : m_files) {
-        if(progress_token.cancelled()) {
-            break;
+        if(file->has_unsaved_changes()) {
+            dirty_files.push_back(file.get());
         }
+    }
+    result.skipped_count = m_files.size() - dirty_files.size();
+    progress_token.set_max_progress(static_cast<int>(dirty_files.size()));
+
+    // Loading touches the residency manager, so it is done before the workers start.
+    std::vector<std::string> errors(dirty_files.size());
+    for(size_t i = 0; i < dirty_files.size(); ++i) {
         try {
-            file->save_file();
+            load_fully(*dirty_files[i]);
+        }
+        catch(const std::exception& e) {
+            errors[i] = e.what();
+        }
+    }
+    const unsigned thread_count = m_save_options.thread_count > 0 ? m_save_options.thread_count
+        : std::max(1u, std::thread::hardware_concurrency());
+    Semaphore write_semaphore(std::max(1u, m_save_options.max_concurrent_writes));
+    Semaphore full_save_semaphore(std::max(1u, m_save_options.max_concurrent_full_saves));
+    std::atomic<size_t> next_index{0};
+    std::mutex progress_mutex;
+
+    auto save_files = [&] {
+        for(size_t i = next_index++; i < dirty_files.size(); i = next_index++) {
+            if(progress_token.cancelled()) {
+                return;
+            }
+            if(errors[i].empty()) {
+                try {
+                    save_file(*dirty_files[i], write_semaphore, full_save_semaphore);
+
+                    if(!m_save_options.durable && dirty_files[i]->has_staged_file()) {
+                        dirty_files[i]->commit_staged_file();
+                    }
+                }
+                catch(const std::exception& e) {
+                    errors[i] = e.what();
+                    dirty_files[i]->discard_staged_file();
+                }
+            }
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            progress_token.increment_progress();
+        }
+    };
+    std::vector<std::thread> workers;
+    for(unsigned i = 1; i < std::min<size_t>(thread_count, dirty_files.size()); ++i) {
+        workers.emplace_back(save_files);
+    }
+    save_files();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+    if(m_save_options.durable) {
+        commit_durably(dirty_files, errors);
+    }
+    for(size_t i = 0; i < dirty_files.size(); ++i) {
+        // Renaming over a file gives it a new identity. A full save read all values into
+        // memory, which the residency manager may now unload again.
+        if(!dirty_files[i]->has_unsaved_changes()) {
+            remove_from_index(dirty_files[i]);
+            add_to_index(dirty_files[i], make_index_keys(dirty_files[i]->get_path()));
+            m_residency.touch(*dirty_files[i], m_current_file);
+        }
+        if(!errors[i].empty()) {
+            result.errors.push_back("Failed to save file: " + dirty_files[i]->get_path().string() +
+                "\nReason: " + errors[i]);
+            Log::error(result.errors.back());
         }
-        catch(const std::exception&) {
-            ok = false;
+        else if(!dirty_files[i]->has_unsaved_changes()) {
+            ++result.saved_count;
         }
-        progress_token.increment_progress();
     }
+    Log::info("Saved " + std::to_string(result.saved_count) + " files with " + std::to_string(thread_count) +
+        " threads, skipped " + std::to_string(result.skipped_count) + " files without unsaved changes");
     file_saved();
-    return ok;
+    return result;
+}
+
+void Dicom_files::save_file(Dicom_file& file, Semaphore& write_semaphore, Semaphore& full_save_semaphore) {
+    {
+        Semaphore_guard write_guard(write_semaphore);
+
+        if(file.try_patch_file() || file.try_stream_file(file.get_path())) {
+            return;
+        }
+    }
+    // The full save semaphore is always taken first, so the two cannot deadlock.
+    Semaphore_guard full_save_guard(full_save_semaphore);
+    Semaphore_guard write_guard(write_semaphore);
+    file.stage_full_file(file.get_path());
+}
+
+void Dicom_files::commit_durably(const std::vector<Dicom_file*>& files, std::vector<std::string>& errors) {
+    // Patched files are synced in place, staged files are synced before they replace the originals.
+    // The renames are made durable by syncing each directory once, after all files are replaced.
+    std::set<fs::path> directories;
+
+    for(size_t i = 0; i < files.size(); ++i) {
+        if(!errors[i].empty() || (!files[i]->has_staged_file() && files[i]->has_unsaved_changes())) {
+            continue;
+        }
+        try {
+            if(files[i]->has_staged_file()) {
+                File_util::sync_file(files[i]->get_staged_temp_path());
+                files[i]->commit_staged_file();
+            }
+            else {
+                File_util::sync_file(files[i]->get_path());
+            }
+            directories.insert(files[i]->get_path().parent_path());
+        }
+        catch(const std::exception& e) {
+            files[i]->discard_staged_file();
+            errors[i] = e.what();
+        }
+    }
+    for(const fs::path& directory : directories) {
+        try {
+            File_util::sync_directory(directory);
+        }
+        catch(const std::exception& e) {
+            Log::warning("Failed to sync directory: " + directory.string() + "\nReason: " + std::string(e.what()));
+        }
+    }
+    Log::debug("Synced saved files in " + std::to_string(directories.size()) + " directories");
+}
+
+Dicom_file* Dicom_files::find_file(const fs::path& path) const {
+    return find_file(make_index_keys(path));
+}
+
+Dicom_files::Index_keys Dicom_files::make_index_keys(const fs::path& path) {
+    return {File_util::get_canonical_key(path), File_util::get_identity(path)};
+}
+
+Dicom_file* Dicom_files::find_file(const Index_keys& keys) const {
+    auto path_it = m_path_index.find(keys.path);
+
+    if(path_it != m_path_index.end()) {
+        return path_it->second;
+    }
+    if(keys.identity.valid) {
+        auto identity_it = m_identity_index.find(keys.identity);
+
+        if(identity_it != m_identity_index.end()) {
+            return identity_it->second;
+        }
+    }
+    return nullptr;
+}
+
+void Dicom_files::add_to_index(Dicom_file* file, const Index_keys& keys) {
+    m_path_index[keys.path] = file;
+
+    if(keys.identity.valid) {
+        m_identity_index[keys.identity] = file;
+    }
+    m_index_keys[file] = keys;
+}
+
+void Dicom_files::remove_from_index(Dicom_file* file) {
+    auto it = m_index_keys.find(file);
+
+    if(it == m_index_keys.end()) {
+        return;
+    }
+    const Index_keys& keys = it->second;
+    auto path_it = m_path_index.find(keys.path);
+
+    if(path_it != m_path_index.end() && path_it->second == file) {
+        m_path_index.erase(path_it);
+    }
+    auto identity_it = m_identity_index.find(keys.identity);
+
+    if(identity_it != m_identity_index.end() && identity_it->second == file) {
+        m_identity_index.erase(identity_it);
+    }
+    m_index_keys.erase(it);
+}
+
+void Dicom_files::remove_file(Dicom_file* file) {
+    file_removed(file);
+    remove_from_index(file);
+    m_residency.remove(file);
+    auto it = std::find_if(m_files.begin(), m_files.end(), [file] (auto& other) {
+        return other.get() == file;
+    });
+
+    if(it != m_files.end()) {
+        m_files.erase(it);
+    }
 }
 
 void Dicom_files::set_current_file(Dicom_file* file) {
+    if(file != nullptr) {
+        load_fully(*file);
+    }
     m_current_file = file;
     current_file_set();
 }
+
+void Dicom_files::load_fully(Dicom_file& file) {
+    file.load_fully();
+    m_residency.touch(file, m_current_file);
+}
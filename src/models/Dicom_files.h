@@ -1,38 +1,116 @@
 #pragma once
+#include "common/File_util.h"
 #include "common/Progress_token.h"
+#include "common/Semaphore.h"
 #include "Dicom_file.h"
+#include "models/Residency_manager.h"
 
 #include <eventi/Event.h>
 #include <filesystem>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace fs = std::filesystem;
 
+struct Save_options
+{
+    /** Number of files encoded in parallel. 0 uses one per hardware thread. */
+    unsigned thread_count = 0;
+    /** Number of files written to disk at the same time. */
+    unsigned max_concurrent_writes = 2;
+    /** Number of files saved whole at the same time. Each has all its values in
+     *  memory while it is written, so this bounds the memory used by a save. */
+    unsigned max_concurrent_full_saves = 2;
+    /** Flush saved files to disk before they replace the originals. Each directory
+     *  is flushed once, after all its files are replaced. Files patched in place
+     *  are flushed after the patch, see Dicom_file::try_patch_file. */
+    bool durable = true;
+};
+
+struct Save_result
+{
+    size_t saved_count = 0;
+    /** Files without unsaved changes are not rewritten. */
+    size_t skipped_count = 0;
+    std::vector<std::string> errors;
+
+    bool ok() const {return errors.empty();}
+};
+
 class Dicom_files
 {
 public:
+    /** Where a file is found in the index of open files. */
+    struct Index_keys
+    {
+        std::string path;
+        File_identity identity;
+    };
+
     Dicom_files();
 
     eventi::Event<> current_file_set;
+    /** Raised by loaders after a batch of files has been added. */
+    eventi::Event<> files_added;
     eventi::Event<> file_saved;
+    /** Raised before a file is closed. */
+    eventi::Event<const Dicom_file*> file_removed;
     eventi::Event<> all_files_edited;
 
     void create_new_file(const fs::path&);
     void open_file(const fs::path&);
+    /** Add an already loaded file. Replaces an open file with the same path. */
+    Dicom_file* add_file(std::unique_ptr<Dicom_file>);
+    /** As above, with keys made by make_index_keys(), e.g. on another thread. */
+    Dicom_file* add_file(std::unique_ptr<Dicom_file>, const Index_keys&);
+    /** Reads the file system, but not the open files. Can be called from any thread. */
+    static Index_keys make_index_keys(const fs::path&);
     bool has_unsaved_changes() const;
 
     void clear_all_files();
 
     void save_current_file_as(const fs::path&);
-    bool save_all_files(Progress_token&);
+    /** Save the files that have unsaved changes. */
+    Save_result save_all_files(Progress_token&);
 
     Dicom_file* get_current_file() {return m_current_file;}
+    /** Set current file. A file that was opened header-only is loaded fully.
+     *  If that fails, an exception is thrown and the current file is kept. */
     void set_current_file(Dicom_file*);
+    /** Fully load a file before it is edited or saved. Other files may be
+     *  unloaded to stay within the memory budget. */
+    void load_fully(Dicom_file&);
+
+    size_t get_memory_budget() const {return m_residency.get_budget();}
+    void set_memory_budget(size_t bytes) {m_residency.set_budget(bytes);}
+
+    const Load_options& get_load_options() const {return m_load_options;}
+    void set_load_options(const Load_options& options) {m_load_options = options;}
+    const Save_options& get_save_options() const {return m_save_options;}
+    void set_save_options(const Save_options& options) {m_save_options = options;}
 
     auto& get_files() {return m_files;}
+    /** Returns the open file at path, or nullptr. Symlinks and other paths
+     *  to the same file are detected by file identity. */
+    Dicom_file* find_file(const fs::path&) const;
+    bool is_open(const Dicom_file* file) const {return m_index_keys.count(file) > 0;}
 
 private:
+    Dicom_file* find_file(const Index_keys&) const;
+    void add_to_index(Dicom_file*, const Index_keys&);
+    void remove_from_index(Dicom_file*);
+    void remove_file(Dicom_file*);
+    static void save_file(Dicom_file&, Semaphore& write_semaphore, Semaphore& full_save_semaphore);
+    static void commit_durably(const std::vector<Dicom_file*>&, std::vector<std::string>& errors);
+
     Dicom_file* m_current_file;
+    Load_options m_load_options;
+    Save_options m_save_options;
+    Residency_manager m_residency;
     std::vector<std::unique_ptr<Dicom_file>> m_files;
+    std::unordered_map<std::string, Dicom_file*> m_path_index;
+    std::unordered_map<File_identity, Dicom_file*, File_identity_hash> m_identity_index;
+    std::unordered_map<const Dicom_file*, Index_keys> m_index_keys;
 };
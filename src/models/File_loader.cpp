@@ -0,0 +1,342 @@
+#include "models/File_loader.h"
+
+#include "common/Dicom_util.h"
+#include "common/File_util.h"
+#include "logging/Log.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+/* How many files each worker may have parsed but not yet committed.
+*  Bounds memory use when the committer falls behind. */
+const size_t max_in_flight_per_thread{16};
+const std::chrono::milliseconds cancel_poll_interval{50};
+const std::chrono::milliseconds commit_interval{250};
+
+File_loader::File_loader(Dicom_files& files, Progress_token& progress_token)
+    : m_files(files),
+      m_progress_token(progress_token),
+      m_thread_count(0),
+      m_catalog(nullptr),
+      m_commit_runner([] (const std::function<void()>& commit) {commit();}),
+      m_skip_non_dicom(false),
+      m_produced_count(0),
+      m_committed_count(0),
+      m_max_in_flight(0),
+      m_producer_done(false),
+      m_stopped(false),
+      m_batch_count(0),
+      m_last_committed_file(nullptr),
+      m_opened_count(0),
+      m_catalog_hit_count(0),
+      m_skipped_count(0) {}
+
+void File_loader::set_thread_count(unsigned count) {
+    m_thread_count = count;
+}
+
+void File_loader::set_catalog(Folder_catalog* catalog) {
+    m_catalog = catalog;
+}
+
+void File_loader::set_commit_runner(Commit_runner runner) {
+    m_commit_runner = std::move(runner);
+}
+
+void File_loader::load_files(const std::vector<fs::path>& paths) {
+    m_skip_non_dicom = false;
+    m_progress_token.set_max_progress(static_cast<int>(paths.size()));
+    load([&] (const Path_sink& sink) {
+        for(const fs::path& path : paths) {
+            if(!sink(path)) {
+                return;
+            }
+        }
+    });
+}
+
+void File_loader::load_folder(const fs::path& dir) {
+    m_skip_non_dicom = true;
+    load([&] (const Path_sink& sink) {
+        int file_count = 0;
+        const auto options = fs::directory_options::skip_permission_denied;
+        for(const fs::directory_entry& entry : fs::recursive_directory_iterator(dir, options)) {
+            std::error_code error;
+
+            // Temporary files of a save in progress are not part of the folder.
+            if(!entry.is_regular_file(error) || File_util::is_temp_path(entry.path())) {
+                continue;
+            }
+            // Raised before the path is handed on, so progress never passes the maximum.
+            m_progress_token.set_max_progress(++file_count);
+
+            if(!sink(entry.path())) {
+                return;
+            }
+        }
+    });
+}
+
+void File_loader::load(const Path_source& source) {
+    m_paths.clear();
+    m_results.clear();
+    m_produced_count = 0;
+    m_committed_count = 0;
+    m_producer_done = false;
+    m_stopped = false;
+    m_batch.clear();
+    m_batch_count = 0;
+    m_last_committed_file = nullptr;
+    m_catalog_entries.clear();
+    m_load_options = m_files.get_load_options();
+
+    const unsigned thread_count = m_thread_count > 0 ? m_thread_count
+        : std::max(1u, std::thread::hardware_concurrency());
+    m_max_in_flight = max_in_flight_per_thread * thread_count;
+    const auto start_time = std::chrono::steady_clock::now();
+    auto last_commit_time = start_time;
+
+    std::vector<std::thread> workers;
+    for(unsigned i = 0; i < thread_count; ++i) {
+        workers.emplace_back([this] {parse();});
+    }
+    std::thread producer([this, &source] {produce(source);});
+
+    while(true) {
+        if(m_progress_token.cancelled()) {
+            break;
+        }
+        const auto now = std::chrono::steady_clock::now();
+
+        if(!m_batch.empty() && now - last_commit_time >= commit_interval) {
+            commit_batch();
+            last_commit_time = now;
+        }
+        Result result;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            const bool ready = m_result_added.wait_for(lock, cancel_poll_interval, [this] {
+                return m_results.count(m_committed_count) > 0
+                    || (m_producer_done && m_committed_count == m_produced_count);
+            });
+            if(!ready) {
+                continue;
+            }
+            auto it = m_results.find(m_committed_count);
+
+            if(it == m_results.end()) {
+                break;
+            }
+            result = std::move(it->second);
+            m_results.erase(it);
+            ++m_committed_count;
+        }
+        m_result_committed.notify_one();
+        m_batch.push_back(std::move(result));
+    }
+    stop();
+    producer.join();
+
+    for(std::thread& worker : workers) {
+        worker.join();
+    }
+    commit_batch();
+
+    if(m_catalog != nullptr) {
+        /* Entries of files that were removed from the folder are only
+        *  dropped when the whole folder has been walked. */
+        if(!m_progress_token.cancelled()) {
+            m_catalog->clear();
+        }
+        for(const auto& [path, entry] : m_catalog_entries) {
+            m_catalog->put(path, entry);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start_time;
+    log_statistics(elapsed.count());
+}
+
+void File_loader::produce(const Path_source& source) {
+    auto sink = [this] (const fs::path& path) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_result_committed.wait(lock, [this] {
+            return m_stopped || m_produced_count - m_committed_count < m_max_in_flight;
+        });
+        if(m_stopped) {
+            return false;
+        }
+        m_paths.emplace_back(m_produced_count++, path);
+        m_path_added.notify_one();
+        return true;
+    };
+    try {
+        source(sink);
+    }
+    catch(const std::exception& e) {
+        Log::error("Failed to list files.\nReason: " + std::string(e.what()));
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_producer_done = true;
+    m_result_added.notify_one();
+}
+
+void File_loader::parse() {
+    while(true) {
+        std::pair<size_t, fs::path> job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_path_added.wait(lock, [this] {return m_stopped || !m_paths.empty();});
+
+            if(m_stopped) {
+                return;
+            }
+            job = std::move(m_paths.front());
+            m_paths.pop_front();
+        }
+        Result result;
+        result.path = job.second;
+        try {
+            parse_file(result);
+
+            // Made here, so the committer does not wait for the file system.
+            if(result.file) {
+                result.index_keys = Dicom_files::make_index_keys(result.path);
+            }
+        }
+        catch(const std::exception& e) {
+            result.error = e.what();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_results.emplace(job.first, std::move(result));
+        }
+        m_result_added.notify_one();
+    }
+}
+
+void File_loader::parse_file(Result& result) {
+    if(m_catalog != nullptr && find_in_catalog(result)) {
+        return;
+    }
+    if(m_skip_non_dicom && !Dicom_util::looks_like_dicom(result.path)) {
+        result.skipped = true;
+        return;
+    }
+    result.file = std::make_unique<Dicom_file>(result.path, m_load_options);
+
+    if(m_catalog != nullptr) {
+        result.catalog_entry.summary = result.file->get_summary();
+    }
+}
+
+bool File_loader::find_in_catalog(Result& result) const {
+    std::error_code error;
+    Folder_catalog::Entry& entry = result.catalog_entry;
+    entry.size = fs::file_size(result.path, error);
+
+    if(!error) {
+        entry.modified_time = fs::last_write_time(result.path, error).time_since_epoch().count();
+    }
+    if(error) {
+        throw std::runtime_error(error.message());
+    }
+    const File_summary* summary = m_catalog->find(result.path, entry.size, entry.modified_time);
+
+    if(summary == nullptr) {
+        return false;
+    }
+    result.file = std::make_unique<Dicom_file>(result.path, *summary, m_load_options);
+    result.catalog_hit = true;
+    entry.summary = *summary;
+    return true;
+}
+
+void File_loader::commit_batch() {
+    if(m_batch.empty()) {
+        return;
+    }
+    m_commit_runner([this] {
+        const size_t opened_count = m_opened_count;
+
+        for(Result& result : m_batch) {
+            commit(result);
+        }
+        if(m_opened_count > opened_count) {
+            m_files.files_added();
+        }
+        /* Show the first files early, and don't move away from the current
+        *  file later unless it was replaced. */
+        const bool set_current = m_batch_count == 0 || m_files.get_current_file() == nullptr;
+
+        if(set_current && m_last_committed_file != nullptr && m_files.is_open(m_last_committed_file)) {
+            try {
+                m_files.set_current_file(m_last_committed_file);
+            }
+            catch(const std::exception& e) {
+                m_errors.push_back("Failed to load file: " + m_last_committed_file->get_path().string() +
+                    "\nReason: " + std::string(e.what()));
+            }
+        }
+    });
+    m_batch.clear();
+    ++m_batch_count;
+}
+
+void File_loader::commit(Result& result) {
+    try {
+        if(result.skipped) {
+            ++m_skipped_count;
+        }
+        else if(!result.file) {
+            throw std::runtime_error(result.error);
+        }
+        else {
+            m_last_committed_file = m_files.add_file(std::move(result.file), result.index_keys);
+            ++m_opened_count;
+
+            if(m_catalog != nullptr) {
+                m_catalog_entries.emplace_back(result.path, result.catalog_entry);
+                m_catalog_hit_count += result.catalog_hit ? 1 : 0;
+            }
+        }
+    }
+    catch(const std::exception& e) {
+        m_errors.push_back("Failed to open file: " + result.path.string() +
+            "\nReason: " + std::string(e.what()));
+    }
+    m_progress_token.increment_progress();
+}
+
+void File_loader::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_path_added.notify_all();
+    m_result_committed.notify_all();
+}
+
+void File_loader::log_statistics(double seconds) const {
+    const double files_per_second = seconds > 0.0 ? m_opened_count / seconds : 0.0;
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1)
+        << "Opened " << m_opened_count << " files in " << seconds << " s ("
+        << files_per_second << " files/s)";
+
+    if(m_catalog != nullptr) {
+        message << ", " << m_catalog_hit_count << " from catalog";
+    }
+    if(m_skipped_count > 0) {
+        message << ", " << m_skipped_count << " skipped as not DICOM";
+    }
+    if(!m_errors.empty()) {
+        message << ", " << m_errors.size() << " failed";
+    }
+    Log::info(message.str());
+}
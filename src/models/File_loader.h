@@ -0,0 +1,107 @@
+#pragma once
+#include "common/Progress_token.h"
+#include "models/Dicom_files.h"
+#include "models/Folder_catalog.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/** Opens files into Dicom_files using one path producer, a pool of parse
+ *  workers and a single committer. Files are committed in the order the
+ *  producer found them, in batches so they can be shown while the load
+ *  continues. When the first batch is committed, its last file becomes the
+ *  current file.
+ */
+class File_loader
+{
+public:
+    /** Hands a path to the loader. Returns false if the load was cancelled. */
+    using Path_sink = std::function<bool(const fs::path&)>;
+    using Path_source = std::function<void(const Path_sink&)>;
+    /** Runs a batch commit and returns when it is done. */
+    using Commit_runner = std::function<void(const std::function<void()>&)>;
+
+    File_loader(Dicom_files&, Progress_token&);
+
+    /** Set number of parse workers. 0 uses one worker per hardware thread. */
+    void set_thread_count(unsigned);
+    /** Files found unchanged in the catalog are not parsed. The catalog is
+     *  updated with the loaded files. */
+    void set_catalog(Folder_catalog*);
+    /** Batches are committed through the runner, e.g. on the GUI thread. By
+     *  default they are committed on the thread that calls load(). */
+    void set_commit_runner(Commit_runner);
+
+    void load_files(const std::vector<fs::path>&);
+    /** Files in the folder that do not look like DICOM files are skipped without being reported as errors.
+     *  The progress maximum is raised as files are found. */
+    void load_folder(const fs::path&);
+    void load(const Path_source&);
+
+    const std::vector<std::string>& get_errors() const {return m_errors;}
+    size_t get_opened_count() const {return m_opened_count;}
+    size_t get_catalog_hit_count() const {return m_catalog_hit_count;}
+    size_t get_skipped_count() const {return m_skipped_count;}
+
+private:
+    struct Result
+    {
+        fs::path path;
+        std::unique_ptr<Dicom_file> file;
+        Dicom_files::Index_keys index_keys;
+        std::string error;
+        Folder_catalog::Entry catalog_entry;
+        bool catalog_hit = false;
+        bool skipped = false;
+    };
+
+    void produce(const Path_source&);
+    void parse();
+    void parse_file(Result&);
+    /** Adds the file from its catalog summary if it is unchanged. */
+    bool find_in_catalog(Result&) const;
+    void commit_batch();
+    void commit(Result&);
+    void stop();
+    void log_statistics(double seconds) const;
+
+    Dicom_files& m_files;
+    Progress_token& m_progress_token;
+    unsigned m_thread_count;
+    Load_options m_load_options;
+    Folder_catalog* m_catalog;
+    Commit_runner m_commit_runner;
+    bool m_skip_non_dicom;
+
+    std::mutex m_mutex;
+    std::condition_variable m_path_added;
+    std::condition_variable m_result_added;
+    std::condition_variable m_result_committed;
+    std::deque<std::pair<size_t, fs::path>> m_paths;
+    std::map<size_t, Result> m_results;
+    size_t m_produced_count;
+    size_t m_committed_count;
+    size_t m_max_in_flight;
+    bool m_producer_done;
+    bool m_stopped;
+    std::vector<Result> m_batch;
+    size_t m_batch_count;
+    Dicom_file* m_last_committed_file;
+
+    std::vector<std::string> m_errors;
+    std::vector<std::pair<fs::path, Folder_catalog::Entry>> m_catalog_entries;
+    size_t m_opened_count;
+    size_t m_catalog_hit_count;
+    size_t m_skipped_count;
+};
@@ -0,0 +1,20 @@
+#pragma once
+#include <string>
+
+/** The attributes needed to place a file in the file tree and in the slice
+ *  order of its series without parsing it. */
+struct File_summary
+{
+    std::string patient_id;
+    std::string patient_name;
+    std::string study_instance_uid;
+    std::string study_description;
+    std::string series_instance_uid;
+    std::string series_description;
+    std::string sop_class_uid;
+    std::string transfer_syntax_uid;
+    std::string instance_number;
+    /** Values as encoded, separated by backslashes. */
+    std::string image_position_patient;
+    std::string image_orientation_patient;
+};
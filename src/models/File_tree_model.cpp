@@ -2,7 +2,6 @@
 
 #include "logging/Log.h"
 
-#include <algorithm>
 #include <dcmtk/dcmdata/dcdeftag.h>
 
 template<class T>
@@ -63,39 +62,76 @@ File_tree_model::File_tree_model(Dicom_files& files)
 
 void File_tree_model::setup_event_callbacks() {
     m_files.file_saved.add_callback([this] {update_model();});
+    m_files.files_added.add_callback([this] {add_new_items();});
+    // Removed right away, a new file can get the address of the removed one.
+    m_files.file_removed.add_callback([this] (const Dicom_file* file) {remove_item(file);});
 }
 
 void File_tree_model::update_model() {
     QMetaObject::invokeMethod(this, [this] {
-        add_items();
+        add_items(false);
         prune_items();
         Log::debug("File tree model updated");
     });
 }
 
-void File_tree_model::add_items() {
+void File_tree_model::add_new_items() {
+    QMetaObject::invokeMethod(this, [this] {
+        add_items(true);
+        prune_items();
+        Log::debug("File tree model updated with new files");
+    });
+}
+
+void File_tree_model::add_items(bool new_files_only) {
+    for(auto& file : m_files.get_files()) {
+        if(!new_files_only || m_file_items.count(file.get()) == 0) {
+            add_item(*file);
+        }
+    }
+}
+
+void File_tree_model::add_item(Dicom_file& file) {
     QString text;
     const char* id = nullptr;
+    DcmDataset& dataset = file.get_dataset();
 
-    for(auto& file : m_files.get_files()) {
-        DcmDataset& dataset = file->get_dataset();
+    text = get_patient_text(dataset);
+    dataset.findAndGetString(DCM_PatientID, id);
+    QStandardItem* patient_item = find_or_create_item<QString>(invisibleRootItem(), text, id);
+
+    text = get_study_text(dataset);
+    dataset.findAndGetString(DCM_StudyInstanceUID, id);
+    QStandardItem* study_item = find_or_create_item<QString>(patient_item, text, id);
+
+    text = get_series_text(dataset);
+    dataset.findAndGetString(DCM_SeriesInstanceUID, id);
+    QStandardItem* series_item = find_or_create_item<QString>(study_item, text, id);
 
-        text = get_patient_text(dataset);
-        dataset.findAndGetString(DCM_PatientID, id);
-        QStandardItem* patient_item = find_or_create_item<QString>(invisibleRootItem(), text, id);
+    const QString file_path = QString::fromStdString(file.get_path().string());
+    QStandardItem*& file_item = m_file_items[&file];
 
-        text = get_study_text(dataset);
-        dataset.findAndGetString(DCM_StudyInstanceUID, id);
-        QStandardItem* study_item = find_or_create_item<QString>(patient_item, text, id);
+    // A file that is not in the model has no item to search for.
+    if(file_item == nullptr) {
+        file_item = new QStandardItem(file_path);
+        file_item->setData(QVariant::fromValue(&file));
+        series_item->appendRow(file_item);
+    }
+    else {
+        file_item = find_or_create_item<Dicom_file*>(series_item, file_path, &file);
+    }
+    decorate_file_item(*file_item);
+}
 
-        text = get_series_text(dataset);
-        dataset.findAndGetString(DCM_SeriesInstanceUID, id);
-        QStandardItem* series_item = find_or_create_item<QString>(study_item, text, id);
+void File_tree_model::remove_item(const Dicom_file* file) {
+    auto it = m_file_items.find(file);
 
-        std::string file_path = file->get_path().string();
-        QStandardItem* file_item = find_or_create_item<Dicom_file*>(series_item, QString::fromStdString(file_path), file.get());
-        decorate_file_item(*file_item);
+    if(it == m_file_items.end()) {
+        return;
     }
+    QStandardItem* file_item = it->second;
+    file_item->parent()->removeRow(file_item->row());
+    m_file_items.erase(it);
 }
 
 void File_tree_model::prune_items() {
@@ -114,6 +150,12 @@ void File_tree_model::prune_items() {
                     QStandardItem* file_item = series_item->child(l);
 
                     if(is_file_item_invalid(*file_item)) {
+                        auto it = m_file_items.find(file_item->data().value<Dicom_file*>());
+
+                        // A file that moved to another series already has a new item.
+                        if(it != m_file_items.end() && it->second == file_item) {
+                            m_file_items.erase(it);
+                        }
                         series_item->removeRow(l);
                     }
                 }
@@ -132,13 +174,9 @@ void File_tree_model::prune_items() {
 }
 
 bool File_tree_model::is_file_item_invalid(const QStandardItem& item) {
-    auto& files = m_files.get_files();
     auto file = item.data().value<Dicom_file*>();
 
-    bool deleted = std::none_of(files.cbegin(), files.cend(), [file] (auto& other) {
-        return file == other.get();
-    });
-    if(deleted) {
+    if(!m_files.is_open(file)) {
         return true;
     }
     const char* id = nullptr;
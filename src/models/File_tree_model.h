@@ -2,6 +2,7 @@
 #include "models/Dicom_files.h"
 
 #include <QStandardItemModel>
+#include <unordered_map>
 
 Q_DECLARE_METATYPE(Dicom_file*)
 
@@ -12,13 +13,18 @@ public:
     File_tree_model(Dicom_files& files);
 
     void update_model();
+    /** Adds files that are not in the model yet, without updating the others. */
+    void add_new_items();
 
 private:
     void setup_event_callbacks();
-    void add_items();
+    void add_items(bool new_files_only);
+    void add_item(Dicom_file&);
+    void remove_item(const Dicom_file*);
     void prune_items();
     bool is_file_item_invalid(const QStandardItem&);
     void decorate_file_item(QStandardItem&);
 
     Dicom_files& m_files;
+    std::unordered_map<const Dicom_file*, QStandardItem*> m_file_items;
 };
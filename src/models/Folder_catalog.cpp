@@ -0,0 +1,172 @@
+#include "models/Folder_catalog.h"
+
+#include "common/File_util.h"
+
+#include <array>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+
+const std::array<char, 8> catalog_magic = {'D', 'C', 'M', 'E', 'C', 'A', 'T', '\0'};
+const uint32_t catalog_version = 2;
+const uint32_t max_string_length = 64 * 1024;
+
+static void write_uint(std::ostream& stream, uint64_t value, int byte_count) {
+    for(int i = 0; i < byte_count; ++i) {
+        stream.put(static_cast<char>((value >> (8 * i)) & 0xff));
+    }
+}
+
+static void write_string(std::ostream& stream, const std::string& value) {
+    write_uint(stream, value.size(), 4);
+    stream.write(value.data(), static_cast<std::streamsize>(value.size()));
+}
+
+static uint64_t read_uint(std::istream& stream, int byte_count) {
+    uint64_t value = 0;
+    for(int i = 0; i < byte_count; ++i) {
+        const int byte = stream.get();
+
+        if(byte == std::char_traits<char>::eof()) {
+            throw std::runtime_error("unexpected end of catalog");
+        }
+        value |= static_cast<uint64_t>(byte) << (8 * i);
+    }
+    return value;
+}
+
+static std::string read_string(std::istream& stream) {
+    const auto length = static_cast<uint32_t>(read_uint(stream, 4));
+
+    if(length > max_string_length) {
+        throw std::runtime_error("catalog is corrupt");
+    }
+    std::string value(length, '\0');
+    stream.read(value.data(), length);
+
+    if(!stream) {
+        throw std::runtime_error("unexpected end of catalog");
+    }
+    return value;
+}
+
+static void write_summary(std::ostream& stream, const File_summary& summary) {
+    write_string(stream, summary.patient_id);
+    write_string(stream, summary.patient_name);
+    write_string(stream, summary.study_instance_uid);
+    write_string(stream, summary.study_description);
+    write_string(stream, summary.series_instance_uid);
+    write_string(stream, summary.series_description);
+    write_string(stream, summary.sop_class_uid);
+    write_string(stream, summary.transfer_syntax_uid);
+    write_string(stream, summary.instance_number);
+    write_string(stream, summary.image_position_patient);
+    write_string(stream, summary.image_orientation_patient);
+}
+
+static File_summary read_summary(std::istream& stream) {
+    File_summary summary;
+    summary.patient_id = read_string(stream);
+    summary.patient_name = read_string(stream);
+    summary.study_instance_uid = read_string(stream);
+    summary.study_description = read_string(stream);
+    summary.series_instance_uid = read_string(stream);
+    summary.series_description = read_string(stream);
+    summary.sop_class_uid = read_string(stream);
+    summary.transfer_syntax_uid = read_string(stream);
+    summary.instance_number = read_string(stream);
+    summary.image_position_patient = read_string(stream);
+    summary.image_orientation_patient = read_string(stream);
+    return summary;
+}
+
+Folder_catalog::Folder_catalog(const fs::path& root)
+    : m_root(root.lexically_normal()) {
+    if(!m_root.has_filename()) {
+        m_root = m_root.parent_path();
+    }
+}
+
+const File_summary* Folder_catalog::find(const fs::path& path, uint64_t size, int64_t modified_time) const {
+    auto it = m_entries.find(make_key(path));
+
+    if(it == m_entries.end() || it->second.size != size || it->second.modified_time != modified_time) {
+        return nullptr;
+    }
+    return &it->second.summary;
+}
+
+void Folder_catalog::put(const fs::path& path, const Entry& entry) {
+    m_entries[make_key(path)] = entry;
+}
+
+void Folder_catalog::load(const fs::path& file_path) {
+    m_entries.clear();
+    std::ifstream file(file_path, std::ios_base::binary);
+
+    if(!file.is_open()) {
+        return;
+    }
+    std::array<char, 8> magic;
+    file.read(magic.data(), magic.size());
+
+    if(!file || magic != catalog_magic) {
+        throw std::runtime_error("not a catalog file");
+    }
+    if(read_uint(file, 4) != catalog_version) {
+        throw std::runtime_error("unsupported catalog version");
+    }
+    const uint64_t entry_count = read_uint(file, 8);
+
+    for(uint64_t i = 0; i < entry_count; ++i) {
+        std::string key = read_string(file);
+        Entry entry;
+        entry.size = read_uint(file, 8);
+        entry.modified_time = static_cast<int64_t>(read_uint(file, 8));
+        entry.summary = read_summary(file);
+        m_entries.emplace(std::move(key), std::move(entry));
+    }
+}
+
+void Folder_catalog::save(const fs::path& file_path) const {
+    fs::create_directories(file_path.parent_path());
+    fs::path temp_path = file_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file(temp_path, std::ios_base::binary | std::ios_base::trunc);
+        file.write(catalog_magic.data(), catalog_magic.size());
+        write_uint(file, catalog_version, 4);
+        write_uint(file, m_entries.size(), 8);
+
+        for(const auto& [key, entry] : m_entries) {
+            write_string(file, key);
+            write_uint(file, entry.size, 8);
+            write_uint(file, static_cast<uint64_t>(entry.modified_time), 8);
+            write_summary(file, entry.summary);
+        }
+        if(!file.good()) {
+            throw std::runtime_error("failed to write catalog");
+        }
+    }
+    fs::rename(temp_path, file_path);
+}
+
+fs::path Folder_catalog::get_catalog_path(const fs::path& cache_dir, const fs::path& root) {
+    // FNV-1a hash of the canonical root path.
+    uint64_t hash = 14695981039346656037ull;
+    for(char c : File_util::get_canonical_key(root)) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << hash << ".catalog";
+    return cache_dir / name.str();
+}
+
+std::string Folder_catalog::make_key(const fs::path& path) const {
+    const fs::path normal_path = path.lexically_normal();
+    const fs::path relative_path = normal_path.lexically_relative(m_root);
+    return relative_path.empty() ? normal_path.generic_string() : relative_path.generic_string();
+}
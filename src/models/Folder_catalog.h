@@ -0,0 +1,44 @@
+#pragma once
+#include "models/File_summary.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+/** Remembers the summary of each file in a folder, so the folder can be
+ *  reopened without parsing files that have not changed since last time.
+ */
+class Folder_catalog
+{
+public:
+    struct Entry
+    {
+        uint64_t size = 0;
+        int64_t modified_time = 0;
+        File_summary summary;
+    };
+
+    Folder_catalog(const fs::path& root);
+
+    /** Returns nullptr if the file is unknown or its size or modification time has changed. */
+    const File_summary* find(const fs::path&, uint64_t size, int64_t modified_time) const;
+    void put(const fs::path&, const Entry&);
+    void clear() {m_entries.clear();}
+    size_t size() const {return m_entries.size();}
+
+    /** Load the catalog from file. A missing file gives an empty catalog. */
+    void load(const fs::path&);
+    void save(const fs::path&) const;
+
+    /** Returns where the catalog for the folder root is stored in cache_dir. */
+    static fs::path get_catalog_path(const fs::path& cache_dir, const fs::path& root);
+
+private:
+    std::string make_key(const fs::path&) const;
+
+    fs::path m_root;
+    std::unordered_map<std::string, Entry> m_entries;
+};
@@ -0,0 +1,237 @@
+#include "models/Frame_cache.h"
+
+#include "logging/Log.h"
+
+#include <dcmtk/dcmimage/diregist.h>
+#include <dcmtk/dcmimgle/dcmimage.h>
+#include <dcmtk/dcmimgle/dipixel.h>
+#include <chrono>
+#include <functional>
+#include <iterator>
+#include <variant>
+
+const size_t default_frame_cache_budget{size_t{512} * 1024 * 1024};
+
+Frame_cache::Frame_cache(Dicom_files& files, Dataset_model& dataset_model)
+    : m_files(files),
+      m_dataset_model(dataset_model),
+      m_budget(default_frame_cache_budget),
+      m_size(0),
+      m_generation(0) {
+    setup_event_callbacks();
+}
+
+void Frame_cache::setup_event_callbacks() {
+    m_dataset_model.dataset_changed.add_callback([this] (const Dataset_change& change) {
+        if(change.affects_image()) {
+            invalidate(m_files.get_current_file());
+        }
+    });
+    m_files.all_files_edited.add_callback([this] {clear();});
+    /* Copies of datasets read values left on disk from the file's path, which a
+    *  save may have replaced. Clearing changes the generation, so frames that
+    *  workers render from the new file at the old offsets are not cached. */
+    m_files.file_saved.add_callback([this] {clear();});
+    m_files.file_removed.add_callback([this] (const Dicom_file* file) {invalidate(file);});
+}
+
+size_t Frame_cache::Key_hash::operator()(const Key& key) const {
+    return std::hash<const Dicom_file*>()(key.file) ^ (std::hash<unsigned long>()(key.frame_index) * 31);
+}
+
+static bool is_image_supported(const DicomImage& image) {
+    auto photo_interp = image.getPhotometricInterpretation();
+    return photo_interp == EPI_Monochrome1
+        || photo_interp == EPI_Monochrome2
+        || photo_interp == EPI_PaletteColor
+        || photo_interp == EPI_RGB;
+}
+
+size_t Rendered_frame::get_data_size() const {
+    return pixel_data.size() + std::visit([] (const auto& values) {
+        return values.size() * sizeof(values[0]);
+    }, modality_values);
+}
+
+template<typename T>
+static void copy_values(const DiPixel& pixel, Modality_values& values) {
+    const auto data = static_cast<const T*>(pixel.getData());
+    values.emplace<std::vector<T>>(data, data + pixel.getCount());
+}
+
+/** Copy the modality values that DicomImage computed from the stored values. */
+static bool copy_modality_values(const DicomImage& image, Modality_values& values) {
+    const DiPixel* pixel = image.getInterData();
+
+    if(pixel == nullptr || pixel->getData() == nullptr) {
+        return false;
+    }
+    switch(pixel->getRepresentation()) {
+        case EPR_Uint8:
+            copy_values<uint8_t>(*pixel, values);
+            return true;
+        case EPR_Sint8:
+            copy_values<int8_t>(*pixel, values);
+            return true;
+        case EPR_Uint16:
+            copy_values<uint16_t>(*pixel, values);
+            return true;
+        case EPR_Sint16:
+            copy_values<int16_t>(*pixel, values);
+            return true;
+        case EPR_Sint32:
+            copy_values<int32_t>(*pixel, values);
+            return true;
+        default:
+            // Uint32 values do not fit an int32_t.
+            return false;
+    }
+}
+
+static bool render_color(DicomImage& image, Rendered_frame& frame) {
+    const int bits_per_sample = 8;
+    frame.pixel_data.resize(image.getOutputDataSize(bits_per_sample));
+
+    // The output is copied so the decoded intermediate data is freed with the DicomImage.
+    if(frame.pixel_data.empty() || !image.getOutputData(frame.pixel_data.data(),
+        frame.pixel_data.size(), bits_per_sample)) {
+        frame.pixel_data.clear();
+        return false;
+    }
+    return true;
+}
+
+Rendered_frame Frame_cache::render_frame(DcmItem& dataset, unsigned long frame_index) {
+    const auto start_time = std::chrono::steady_clock::now();
+    Rendered_frame frame;
+
+    /* Partial access reads only the rendered frame from the pixel data, so
+    *  pixel data that was left on disk is not loaded into the dataset. */
+    DicomImage image(&dataset, EXS_Unknown, CIF_UsePartialAccessToPixelData, frame_index, 1);
+
+    if(!is_image_supported(image)) {
+        frame.error = "Photometric Interpretation not supported";
+        return frame;
+    }
+    frame.monochrome = image.isMonochrome();
+
+    if(frame.monochrome) {
+        image.setMinMaxWindow();
+        image.getWindow(frame.window_center, frame.window_width);
+        frame.inverse = image.getPhotometricInterpretation() == EPI_Monochrome1;
+    }
+    const bool rendered = frame.monochrome ?
+        copy_modality_values(image, frame.modality_values) : render_color(image, frame);
+
+    if(!rendered) {
+        frame.error = image.getStatus() == EIS_Normal ?
+            "Pixel representation not supported" : DicomImage::getString(image.getStatus());
+        return frame;
+    }
+    frame.width = static_cast<int>(image.getWidth());
+    frame.height = static_cast<int>(image.getHeight());
+    frame.frame_count = image.getFrameCount();
+
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start_time);
+    Log::debug("Rendered " + std::to_string(frame.width) + "x" + std::to_string(frame.height) +
+        " frame in " + std::to_string(elapsed.count()) + " ms");
+    return frame;
+}
+
+std::shared_ptr<const Rendered_frame> Frame_cache::get_frame(Dicom_file& file, unsigned long frame_index) {
+    if(auto frame = find(file, frame_index)) {
+        return frame;
+    }
+    // Rendering is done without the lock, so other frames can be served meanwhile.
+    const uint64_t generation = get_generation();
+    return insert(file, frame_index, std::make_shared<const Rendered_frame>(
+        render_frame(file.get_dataset(), frame_index)), generation);
+}
+
+std::shared_ptr<const Rendered_frame> Frame_cache::find(const Dicom_file& file, unsigned long frame_index) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entry_index.find({&file, frame_index});
+
+    if(it == m_entry_index.end()) {
+        return nullptr;
+    }
+    m_entries.splice(m_entries.end(), m_entries, it->second);
+    return it->second->frame;
+}
+
+std::shared_ptr<const Rendered_frame> Frame_cache::insert(const Dicom_file& file, unsigned long frame_index,
+    std::shared_ptr<const Rendered_frame> frame, uint64_t generation) {
+    const Key key{&file, frame_index};
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if(generation != m_generation) {
+        return frame;
+    }
+    auto it = m_entry_index.find(key);
+
+    if(it != m_entry_index.end()) {
+        return it->second->frame;
+    }
+    const size_t size = sizeof(Rendered_frame) + frame->get_data_size();
+    m_entries.push_back({&file, frame_index, frame, size});
+    m_entry_index[key] = std::prev(m_entries.end());
+    m_size += size;
+    evict_until_within_budget();
+    return frame;
+}
+
+void Frame_cache::invalidate(const Dicom_file* file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+    auto it = m_entries.begin();
+
+    while(it != m_entries.end()) {
+        if(it->file == file) {
+            m_size -= it->size;
+            m_entry_index.erase({it->file, it->frame_index});
+            it = m_entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void Frame_cache::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_generation;
+    m_entries.clear();
+    m_entry_index.clear();
+    m_size = 0;
+}
+
+uint64_t Frame_cache::get_generation() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_generation;
+}
+
+size_t Frame_cache::get_budget() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_budget;
+}
+
+void Frame_cache::set_budget(size_t bytes) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_budget = bytes;
+    evict_until_within_budget();
+}
+
+size_t Frame_cache::get_size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_size;
+}
+
+void Frame_cache::evict_until_within_budget() {
+    // The most recent frame is kept even if it alone exceeds the budget.
+    while(m_size > m_budget && m_entries.size() > 1) {
+        const Entry& entry = m_entries.front();
+        m_size -= entry.size;
+        m_entry_index.erase({entry.file, entry.frame_index});
+        m_entries.pop_front();
+    }
+}
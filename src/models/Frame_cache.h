@@ -0,0 +1,114 @@
+#pragma once
+#include "models/Dataset_model.h"
+#include "models/Dicom_file.h"
+#include "models/Dicom_files.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+/** Modality values at the depth DicomImage computed them in, so 8 and 16-bit
+ *  images are not widened to 32 bits. */
+using Modality_values = std::variant<std::vector<uint8_t>, std::vector<int8_t>, std::vector<uint16_t>,
+    std::vector<int16_t>, std::vector<int32_t>>;
+
+/** One decoded frame. Monochrome frames keep their modality values so the
+ *  window can be changed without decoding again, color frames are kept as
+ *  8-bit RGB. */
+struct Rendered_frame
+{
+    /** RGB output of color frames. */
+    std::vector<uint8_t> pixel_data;
+    /** Modality values of monochrome frames, after any rescale or modality LUT. */
+    Modality_values modality_values;
+    /** Initial window of monochrome frames. */
+    double window_center = 0.0;
+    double window_width = 1.0;
+    /** Set for MONOCHROME1, where low values are displayed bright. */
+    bool inverse = false;
+    int width = 0;
+    int height = 0;
+    /** Number of frames in the image the frame belongs to. */
+    unsigned long frame_count = 1;
+    bool monochrome = false;
+    /** Set if the frame could not be rendered. */
+    std::string error;
+
+    /** Returns the size of the pixel data and modality values in bytes. */
+    size_t get_data_size() const;
+};
+
+/** Rendered frames shared by all image views, so a frame shown in several
+ *  views is decoded once. Frames are dropped when an image attribute of their
+ *  file is edited, when files are saved, when the file is closed, or when the
+ *  cache exceeds its budget.
+ *  Views hold frames by reference count, so an evicted frame stays valid while
+ *  it is shown. find() and insert() can be called from any thread, e.g. by
+ *  background decoders. get_frame() renders from the dataset of the file, so
+ *  it must be called on the thread that edits the files.
+ */
+class Frame_cache
+{
+public:
+    Frame_cache(Dicom_files&, Dataset_model&);
+
+    /** Returns the cached frame, rendering it if needed. */
+    std::shared_ptr<const Rendered_frame> get_frame(Dicom_file&, unsigned long frame_index);
+    /** Returns the cached frame, or null if it is not cached. */
+    std::shared_ptr<const Rendered_frame> find(const Dicom_file&, unsigned long frame_index);
+    /** Add a frame rendered elsewhere. A frame already cached for the index is kept.
+     *  The frame is not cached if frames were invalidated since generation. */
+    std::shared_ptr<const Rendered_frame> insert(const Dicom_file&, unsigned long frame_index,
+        std::shared_ptr<const Rendered_frame>, uint64_t generation);
+    void invalidate(const Dicom_file*);
+    void clear();
+    /** Changes whenever frames are invalidated. Frames rendered from a dataset
+     *  copied before the change may be stale. */
+    uint64_t get_generation() const;
+
+    /** Render a frame of the dataset without caching it. Errors are returned in the frame. */
+    static Rendered_frame render_frame(DcmItem&, unsigned long frame_index);
+    size_t get_budget() const;
+    void set_budget(size_t bytes);
+    size_t get_size() const;
+
+private:
+    struct Entry
+    {
+        const Dicom_file* file;
+        unsigned long frame_index;
+        std::shared_ptr<const Rendered_frame> frame;
+        size_t size;
+    };
+    struct Key
+    {
+        const Dicom_file* file;
+        unsigned long frame_index;
+
+        bool operator==(const Key& other) const {
+            return file == other.file && frame_index == other.frame_index;
+        }
+    };
+    struct Key_hash
+    {
+        size_t operator()(const Key&) const;
+    };
+
+    void setup_event_callbacks();
+    void evict_until_within_budget();
+
+    Dicom_files& m_files;
+    Dataset_model& m_dataset_model;
+    mutable std::mutex m_mutex;
+    size_t m_budget;
+    size_t m_size;
+    uint64_t m_generation;
+    std::list<Entry> m_entries;
+    std::unordered_map<Key, std::list<Entry>::iterator, Key_hash> m_entry_index;
+};
@@ -0,0 +1,112 @@
+#include "models/Frame_decoder.h"
+
+#include "logging/Log.h"
+
+#include <algorithm>
+#include <exception>
+#include <string>
+
+Frame_decoder::Frame_decoder(Frame_cache& frame_cache)
+    : m_frame_cache(frame_cache),
+      m_thread_count(0),
+      m_file(nullptr),
+      m_cache_generation(0),
+      m_first_frame(0),
+      m_frame_count(0),
+      m_image_frame_count(1),
+      m_next_frame(0),
+      m_remaining_count(0),
+      m_cancelled(false) {}
+
+Frame_decoder::~Frame_decoder() {
+    cancel();
+}
+
+void Frame_decoder::set_thread_count(unsigned count) {
+    m_thread_count = count;
+}
+
+void Frame_decoder::decode(Dicom_file& file, unsigned long first_frame, unsigned long frame_count,
+    unsigned long image_frame_count) {
+    if(m_file == &file && is_decoding()) {
+        return;
+    }
+    cancel();
+
+    if(frame_count == 0 || image_frame_count == 0) {
+        return;
+    }
+    m_file = &file;
+    m_path = file.get_path();
+    m_cache_generation = m_frame_cache.get_generation();
+    m_first_frame = first_frame;
+    m_frame_count = std::min(frame_count, image_frame_count);
+    m_image_frame_count = image_frame_count;
+    m_start_time = std::chrono::steady_clock::now();
+    m_next_frame = 0;
+    m_remaining_count = m_frame_count;
+    m_cancelled = false;
+
+    const unsigned hardware_thread_count = m_thread_count > 0 ? m_thread_count
+        : std::max(1u, std::thread::hardware_concurrency());
+    auto first_dataset = std::make_unique<Dataset_copy>(file);
+    // Clones are made on this thread and copy any loaded pixel data, so only one is made.
+    const unsigned thread_count = first_dataset->is_from_disk() ?
+        static_cast<unsigned>(std::min<unsigned long>(hardware_thread_count, m_frame_count)) : 1;
+    m_datasets.push_back(std::move(first_dataset));
+
+    while(m_datasets.size() < thread_count) {
+        m_datasets.push_back(std::make_unique<Dataset_copy>(file));
+    }
+    for(auto& dataset : m_datasets) {
+        m_workers.emplace_back([this, &dataset] {work(*dataset);});
+    }
+}
+
+void Frame_decoder::cancel() {
+    m_cancelled = true;
+    wait();
+}
+
+void Frame_decoder::wait() {
+    for(std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    m_datasets.clear();
+}
+
+bool Frame_decoder::is_decoding() const {
+    return !m_workers.empty() && m_remaining_count > 0 && !m_cancelled;
+}
+
+void Frame_decoder::work(Dataset_copy& dataset_copy) {
+    try {
+        DcmItem& dataset = dataset_copy.get();
+
+        while(!m_cancelled) {
+            const unsigned long position = m_next_frame++;
+
+            if(position >= m_frame_count) {
+                return;
+            }
+            const unsigned long index = (m_first_frame + position) % m_image_frame_count;
+
+            if(m_frame_cache.find(*m_file, index) == nullptr) {
+                m_frame_cache.insert(*m_file, index, std::make_shared<const Rendered_frame>(
+                    Frame_cache::render_frame(dataset, index)), m_cache_generation);
+            }
+            // The last worker to finish a frame logs the total time.
+            if(--m_remaining_count == 0) {
+                const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - m_start_time);
+                Log::debug("Decoded " + std::to_string(m_frame_count) + " frames with " +
+                    std::to_string(m_datasets.size()) + " threads in " + std::to_string(elapsed.count()) + " ms");
+            }
+        }
+    }
+    catch(const std::exception& e) {
+        Log::error("Failed to decode frames: " + m_path.string() +
+            "\nReason: " + std::string(e.what()));
+    }
+}
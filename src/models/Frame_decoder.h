@@ -0,0 +1,58 @@
+#pragma once
+#include "models/Dataset_copy.h"
+#include "models/Dicom_file.h"
+#include "models/Frame_cache.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+/** Renders frames of a file into the frame cache on a pool of worker threads.
+ *  Each worker renders from its own copy of the dataset, so frames are decoded
+ *  in parallel and the file can be edited meanwhile. Frames already cached are
+ *  skipped. One decoder is shared by all image views.
+ */
+class Frame_decoder
+{
+public:
+    explicit Frame_decoder(Frame_cache&);
+    ~Frame_decoder();
+    Frame_decoder(const Frame_decoder&) = delete;
+    Frame_decoder& operator=(const Frame_decoder&) = delete;
+
+    /** Set number of workers. 0 uses one worker per hardware thread. */
+    void set_thread_count(unsigned);
+    /** Start rendering frame_count frames from first_frame, wrapping at the end
+     *  of the image. Does nothing if the file is already being decoded, so views
+     *  showing the same file share the workers. A running decode of another file
+     *  is cancelled first. Must be called on the thread that edits the file. */
+    void decode(Dicom_file&, unsigned long first_frame, unsigned long frame_count, unsigned long image_frame_count);
+    /** Stop the workers once their current frames are done. */
+    void cancel();
+    /** Wait until all requested frames are rendered, or the workers are cancelled. */
+    void wait();
+    /** Must be called on the thread that calls decode. */
+    bool is_decoding() const;
+
+private:
+    void work(Dataset_copy&);
+
+    Frame_cache& m_frame_cache;
+    unsigned m_thread_count;
+    const Dicom_file* m_file;
+    fs::path m_path;
+    uint64_t m_cache_generation;
+    unsigned long m_first_frame;
+    unsigned long m_frame_count;
+    unsigned long m_image_frame_count;
+    std::chrono::steady_clock::time_point m_start_time;
+
+    std::vector<std::unique_ptr<Dataset_copy>> m_datasets;
+    std::vector<std::thread> m_workers;
+    std::atomic<unsigned long> m_next_frame;
+    std::atomic<unsigned long> m_remaining_count;
+    std::atomic<bool> m_cancelled;
+};
@@ -0,0 +1,48 @@
+#include "models/Frame_pacer.h"
+
+#include <algorithm>
+#include <utility>
+
+Frame_pacer::Frame_pacer(std::chrono::microseconds frame_interval)
+    : m_frame_interval(frame_interval) {}
+
+void Frame_pacer::set_frame_interval(std::chrono::microseconds frame_interval) {
+    m_frame_interval = frame_interval;
+}
+
+std::optional<std::chrono::microseconds> Frame_pacer::request_frame(Clock::time_point now) {
+    // A scheduled repaint that has not started within a frame is taken as lost, e.g. while the view was hidden.
+    if(m_scheduled_time && now <= *m_scheduled_time + m_frame_interval) {
+        return std::nullopt;
+    }
+    Clock::time_point time = now;
+
+    if(m_frame_start) {
+        time = std::max(now, *m_frame_start + m_frame_interval);
+    }
+    m_scheduled_time = time;
+    return std::chrono::duration_cast<std::chrono::microseconds>(time - now);
+}
+
+void Frame_pacer::start_frame(Clock::time_point now) {
+    m_frame_start = now;
+    m_scheduled_time.reset();
+}
+
+void Frame_pacer::finish_frame(Clock::time_point now) {
+    if(!m_frame_start) {
+        return;
+    }
+    const auto frame_time = std::chrono::duration_cast<std::chrono::microseconds>(now - *m_frame_start);
+    ++m_stats.frame_count;
+    m_stats.total_time += frame_time;
+    m_stats.max_time = std::max(m_stats.max_time, frame_time);
+
+    if(frame_time > m_frame_interval) {
+        ++m_stats.over_budget_count;
+    }
+}
+
+Frame_stats Frame_pacer::take_stats() {
+    return std::exchange(m_stats, Frame_stats());
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <chrono>
+#include <optional>
+
+struct Frame_stats
+{
+    unsigned long frame_count = 0;
+    /** Frames that took longer than the frame interval. */
+    unsigned long over_budget_count = 0;
+    std::chrono::microseconds total_time{0};
+    std::chrono::microseconds max_time{0};
+};
+
+/** Limits repaints to one per display frame, so bursts of input are drawn
+ *  once with their combined effect, and measures the time of each frame
+ *  against the frame interval.
+ */
+class Frame_pacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit Frame_pacer(std::chrono::microseconds frame_interval);
+
+    std::chrono::microseconds get_frame_interval() const {return m_frame_interval;}
+    void set_frame_interval(std::chrono::microseconds);
+    /** Request a repaint. Returns the delay after which to repaint, or nothing
+     *  if a repaint is already scheduled. */
+    std::optional<std::chrono::microseconds> request_frame(Clock::time_point now);
+    /** Mark the start of a repaint, which serves the scheduled request. */
+    void start_frame(Clock::time_point now);
+    /** Mark the end of the repaint started last. */
+    void finish_frame(Clock::time_point now);
+    /** Returns the statistics of the frames finished since the last call. */
+    Frame_stats take_stats();
+
+private:
+    std::chrono::microseconds m_frame_interval;
+    std::optional<Clock::time_point> m_frame_start;
+    /** Set while a repaint is scheduled. */
+    std::optional<Clock::time_point> m_scheduled_time;
+    Frame_stats m_stats;
+};
@@ -0,0 +1,152 @@
+#include "models/Image_pyramid.h"
+
+#include "common/Box_filter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <utility>
+
+const size_t default_pyramid_budget{size_t{256} * 1024 * 1024};
+
+Image_pyramid::Image_pyramid(QSize size, Tile_source source)
+    : m_source(std::move(source)),
+      m_budget(default_pyramid_budget),
+      m_size(0) {
+    m_level_sizes.push_back(size);
+
+    while(size.width() > tile_size || size.height() > tile_size) {
+        size = QSize((size.width() + 1) / 2, (size.height() + 1) / 2);
+        m_level_sizes.push_back(size);
+    }
+}
+
+size_t Image_pyramid::Tile_key_hash::operator()(const Tile_key& key) const {
+    return std::hash<int>()(key.level) ^ (std::hash<int>()(key.x) * 31) ^ (std::hash<int>()(key.y) * 961);
+}
+
+int Image_pyramid::get_level(double scale) const {
+    if(scale <= 0.0 || scale >= 1.0) {
+        return 0;
+    }
+    // Level n is drawn magnified by scale * 2^n, which must not exceed 1.
+    const int level = static_cast<int>(std::floor(std::log2(1.0 / scale)));
+    return std::min(level, get_level_count() - 1);
+}
+
+int Image_pyramid::get_nearest_level(double scale, QSize size) {
+    if(scale <= 0.0 || scale >= 1.0) {
+        return 0;
+    }
+    int level = static_cast<int>(std::lround(std::log2(1.0 / scale)));
+
+    while(level > 0 && std::min(size.width(), size.height()) >> level == 0) {
+        --level;
+    }
+    return level;
+}
+
+std::vector<QPoint> Image_pyramid::get_tiles(int level, const QRectF& rect) const {
+    const double level_scale = std::ldexp(1.0, -level);
+    const QSize size = get_level_size(level);
+    const QRectF level_rect = QRectF(rect.topLeft() * level_scale, rect.size() * level_scale)
+        .intersected(QRectF(QPointF(0, 0), QSizeF(size)));
+    std::vector<QPoint> tiles;
+
+    if(level_rect.isEmpty()) {
+        return tiles;
+    }
+    const int first_x = static_cast<int>(level_rect.left()) / tile_size;
+    const int first_y = static_cast<int>(level_rect.top()) / tile_size;
+    const int last_x = std::min(static_cast<int>(std::ceil(level_rect.right())) - 1, size.width() - 1) / tile_size;
+    const int last_y = std::min(static_cast<int>(std::ceil(level_rect.bottom())) - 1, size.height() - 1) / tile_size;
+
+    for(int y = first_y; y <= last_y; ++y) {
+        for(int x = first_x; x <= last_x; ++x) {
+            tiles.emplace_back(x, y);
+        }
+    }
+    return tiles;
+}
+
+QImage Image_pyramid::get_tile(int level, QPoint tile) {
+    const Tile_key key{level, tile.x(), tile.y()};
+    auto it = m_entry_index.find(key);
+
+    if(it != m_entry_index.end()) {
+        m_entries.splice(m_entries.end(), m_entries, it->second);
+        return it->second->image;
+    }
+    QImage image = build_tile(level, tile);
+    m_entries.push_back({key, image});
+    m_entry_index[key] = std::prev(m_entries.end());
+    m_size += static_cast<size_t>(image.sizeInBytes());
+    evict_until_within_budget();
+    return image;
+}
+
+void Image_pyramid::set_budget(size_t bytes) {
+    m_budget = bytes;
+    evict_until_within_budget();
+}
+
+QRect Image_pyramid::get_tile_rect(int level, QPoint tile) const {
+    const QRect rect(tile * tile_size, QSize(tile_size, tile_size));
+    return rect.intersected(QRect(QPoint(0, 0), get_level_size(level)));
+}
+
+QImage Image_pyramid::build_tile(int level, QPoint tile) {
+    const QRect rect = get_tile_rect(level, tile);
+
+    QImage image(rect.size(), QImage::Format_RGB32);
+
+    if(level == 0) {
+        m_source(rect, reinterpret_cast<uint32_t*>(image.bits()), static_cast<size_t>(image.bytesPerLine()) / 4);
+        return image;
+    }
+    // Each quarter of the tile is a tile of the level below, at half size.
+    image.fill(Qt::black);
+    const int half_tile_size = tile_size / 2;
+
+    for(int dy = 0; dy < 2; ++dy) {
+        for(int dx = 0; dx < 2; ++dx) {
+            const QPoint child(tile.x() * 2 + dx, tile.y() * 2 + dy);
+
+            if(get_tile_rect(level - 1, child).isEmpty()) {
+                continue;
+            }
+            const QImage child_image = get_tile(level - 1, child);
+            const QImage scaled = halve(child_image);
+            const int x = dx * half_tile_size;
+            const int y = dy * half_tile_size;
+            const int width = std::min(scaled.width(), image.width() - x);
+            const int height = std::min(scaled.height(), image.height() - y);
+
+            for(int row = 0; row < height; ++row) {
+                std::memcpy(image.scanLine(y + row) + x * 4, scaled.constScanLine(row), static_cast<size_t>(width) * 4);
+            }
+        }
+    }
+    return image;
+}
+
+QImage Image_pyramid::halve(const QImage& image) {
+    const QImage input = image.convertToFormat(QImage::Format_RGB32);
+    QImage output((input.width() + 1) / 2, (input.height() + 1) / 2, QImage::Format_RGB32);
+    Box_filter::halve_rgb32(reinterpret_cast<const uint32_t*>(input.constBits()), input.width(), input.height(),
+        static_cast<size_t>(input.bytesPerLine()) / 4, reinterpret_cast<uint32_t*>(output.bits()),
+        static_cast<size_t>(output.bytesPerLine()) / 4);
+    return output;
+}
+
+void Image_pyramid::evict_until_within_budget() {
+    // The most recent tile is kept, since the caller holds it.
+    while(m_size > m_budget && m_entries.size() > 1) {
+        const Entry& entry = m_entries.front();
+        m_size -= static_cast<size_t>(entry.image.sizeInBytes());
+        m_entry_index.erase(entry.key);
+        m_entries.pop_front();
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <QImage>
+#include <QPoint>
+#include <QRectF>
+#include <QSize>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+/** Tiles of an image at halving resolutions, built when they are first used,
+ *  so only the parts of a large image that are shown are converted and
+ *  downsampled. Level 0 is the full image, each further level halves its
+ *  width and height until the image fits one tile. The image itself is not
+ *  kept, its level 0 tiles are requested from a source.
+ */
+class Image_pyramid
+{
+public:
+    /** Writes the RGB32 pixels of a rectangle of the image. The stride is in pixels. */
+    using Tile_source = std::function<void(const QRect&, uint32_t* pixels, size_t stride)>;
+
+    static const int tile_size = 256;
+
+    Image_pyramid(QSize, Tile_source);
+
+    int get_level_count() const {return static_cast<int>(m_level_sizes.size());}
+    QSize get_level_size(int level) const {return m_level_sizes[static_cast<size_t>(level)];}
+    /** Returns the smallest level that is not magnified when drawn at scale. */
+    int get_level(double scale) const;
+    /** Returns the tiles of level that intersect rect, which is in level 0 pixels. */
+    std::vector<QPoint> get_tiles(int level, const QRectF& rect) const;
+    /** Returns the tile at column x and row y of level. The tile is valid until the next call. */
+    QImage get_tile(int level, QPoint tile);
+
+    /** Returns the level nearest to scale for an untiled image of size, so it is
+     *  resampled by at most a factor of about 1.4. Levels stop before a side of
+     *  the image would be halved to nothing. */
+    static int get_nearest_level(double scale, QSize);
+    /** Returns an RGB32 image of half the size, box filtered. */
+    static QImage halve(const QImage&);
+
+    size_t get_budget() const {return m_budget;}
+    /** Least recently used tiles are dropped beyond the budget. They are built again when used. */
+    void set_budget(size_t bytes);
+
+private:
+    struct Tile_key
+    {
+        int level;
+        int x;
+        int y;
+
+        bool operator==(const Tile_key& other) const {
+            return level == other.level && x == other.x && y == other.y;
+        }
+    };
+    struct Tile_key_hash
+    {
+        size_t operator()(const Tile_key&) const;
+    };
+    struct Entry
+    {
+        Tile_key key;
+        QImage image;
+    };
+
+    QImage build_tile(int level, QPoint tile);
+    QRect get_tile_rect(int level, QPoint tile) const;
+    void evict_until_within_budget();
+
+    Tile_source m_source;
+    std::vector<QSize> m_level_sizes;
+    size_t m_budget;
+    size_t m_size;
+    std::list<Entry> m_entries;
+    std::unordered_map<Tile_key, std::list<Entry>::iterator, Tile_key_hash> m_entry_index;
+};
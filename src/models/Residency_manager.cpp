@@ -0,0 +1,73 @@
+#include "models/Residency_manager.h"
+
+#include "logging/Log.h"
+
+#include <exception>
+#include <iterator>
+#include <string>
+
+Residency_manager::Residency_manager(size_t budget)
+    : m_budget(budget),
+      m_resident_size(0) {}
+
+void Residency_manager::touch(Dicom_file& file, const Dicom_file* keep_file) {
+    remove(&file);
+
+    // Values read lazily since the last touch are included in the new size.
+    const size_t size = file.get_memory_usage();
+    m_entries.push_back({&file, size});
+    m_entry_index[&file] = std::prev(m_entries.end());
+    m_resident_size += size;
+
+    if(m_resident_size > m_budget) {
+        unload_until_within_budget(&file, keep_file);
+    }
+}
+
+void Residency_manager::remove(const Dicom_file* file) {
+    auto it = m_entry_index.find(file);
+
+    if(it == m_entry_index.end()) {
+        return;
+    }
+    m_resident_size -= it->second->size;
+    m_entries.erase(it->second);
+    m_entry_index.erase(it);
+}
+
+void Residency_manager::clear() {
+    m_entries.clear();
+    m_entry_index.clear();
+    m_resident_size = 0;
+}
+
+void Residency_manager::unload_until_within_budget(const Dicom_file* keep_file_1, const Dicom_file* keep_file_2) {
+    size_t unloaded_count = 0;
+    auto it = m_entries.begin();
+
+    while(m_resident_size > m_budget && it != m_entries.end()) {
+        Dicom_file* file = it->file;
+
+        if(file == keep_file_1 || file == keep_file_2 || file->has_unsaved_changes()) {
+            ++it;
+            continue;
+        }
+        try {
+            file->unload();
+        }
+        catch(const std::exception& e) {
+            Log::error("Failed to unload file: " + file->get_path().string() +
+                "\nReason: " + std::string(e.what()));
+            ++it;
+            continue;
+        }
+        m_resident_size -= it->size;
+        m_entry_index.erase(file);
+        it = m_entries.erase(it);
+        ++unloaded_count;
+    }
+    if(unloaded_count > 0) {
+        Log::debug("Unloaded " + std::to_string(unloaded_count) + " files, " +
+            std::to_string(m_resident_size / (1024 * 1024)) + " MiB resident");
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include "models/Dicom_file.h"
+
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+
+/** Keeps the memory used by open datasets within a budget. When the budget
+ *  is exceeded, the least recently used files without unsaved changes are
+ *  unloaded to their summary. They are parsed again by Dicom_file::load_fully.
+ */
+class Residency_manager
+{
+public:
+    Residency_manager(size_t budget);
+
+    size_t get_budget() const {return m_budget;}
+    void set_budget(size_t bytes) {m_budget = bytes;}
+    size_t get_resident_size() const {return m_resident_size;}
+
+    /** Mark the file as most recently used and unload other files if the
+     *  budget is exceeded. The file itself and keep_file are never unloaded. */
+    void touch(Dicom_file&, const Dicom_file* keep_file = nullptr);
+    void remove(const Dicom_file*);
+    void clear();
+
+private:
+    struct Entry
+    {
+        Dicom_file* file;
+        size_t size;
+    };
+
+    void unload_until_within_budget(const Dicom_file* keep_file_1, const Dicom_file* keep_file_2);
+
+    size_t m_budget;
+    size_t m_resident_size;
+    std::list<Entry> m_entries;
+    std::unordered_map<const Dicom_file*, std::list<Entry>::iterator> m_entry_index;
+};
@@ -0,0 +1,48 @@
+#include "models/Series_navigator.h"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+const size_t default_prefetch_distance{8};
+
+Series_navigator::Series_navigator(Dicom_files& files, Dataset_model& dataset_model, Frame_cache& frame_cache)
+    : m_files(files),
+      m_stack(files, dataset_model),
+      m_prefetcher(files, frame_cache),
+      m_prefetch_distance(default_prefetch_distance),
+      m_direction(1) {
+    m_files.current_file_set.add_callback([this] {prefetch_neighbors();});
+}
+
+bool Series_navigator::step(int steps) {
+    Dicom_file* file = m_files.get_current_file();
+
+    if(file == nullptr || steps == 0) {
+        return false;
+    }
+    Dicom_file* next_file = m_stack.get_neighbor(*file, steps);
+
+    if(next_file == file) {
+        return false;
+    }
+    m_direction = steps;
+
+    if(!next_file->is_fully_loaded() && !next_file->has_unsaved_changes()) {
+        if(std::unique_ptr<DcmFileFormat> parsed_file = m_prefetcher.take_parsed_file(*next_file)) {
+            next_file->load_fully(std::move(parsed_file));
+        }
+    }
+    m_files.set_current_file(next_file);
+    return true;
+}
+
+void Series_navigator::prefetch_neighbors() {
+    Dicom_file* file = m_files.get_current_file();
+
+    if(file == nullptr) {
+        m_prefetcher.clear();
+        return;
+    }
+    m_prefetcher.prefetch(m_stack.get_neighbors(*file, m_prefetch_distance, m_direction));
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "models/Series_prefetcher.h"
+#include "models/Series_stack.h"
+
+#include <cstddef>
+
+/** Steps the current file through the slices of its series. The slices
+ *  around the current file are prefetched, more of them in the direction of
+ *  the last step.
+ */
+class Series_navigator
+{
+public:
+    Series_navigator(Dicom_files&, Dataset_model&, Frame_cache&);
+
+    /** Make the file steps slices away current. Returns false if the current
+     *  file is already at that end of the stack. Throws if the file can't be
+     *  loaded, see Dicom_files::set_current_file. */
+    bool step(int steps);
+    size_t get_prefetch_distance() const {return m_prefetch_distance;}
+    void set_prefetch_distance(size_t distance) {m_prefetch_distance = distance;}
+    Series_stack& get_stack() {return m_stack;}
+    Series_prefetcher& get_prefetcher() {return m_prefetcher;}
+
+private:
+    void prefetch_neighbors();
+
+    Dicom_files& m_files;
+    Series_stack m_stack;
+    Series_prefetcher m_prefetcher;
+    size_t m_prefetch_distance;
+    int m_direction;
+};
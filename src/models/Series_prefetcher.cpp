@@ -0,0 +1,141 @@
+#include "models/Series_prefetcher.h"
+
+#include "logging/Log.h"
+
+#include <exception>
+#include <iterator>
+#include <string>
+#include <utility>
+
+const unsigned prefetch_thread_count{2};
+
+Series_prefetcher::Series_prefetcher(Dicom_files& files, Frame_cache& frame_cache)
+    : m_files(files),
+      m_frame_cache(frame_cache),
+      m_running_count(0),
+      m_stopped(false) {
+    setup_event_callbacks();
+
+    for(unsigned i = 0; i < prefetch_thread_count; ++i) {
+        m_workers.emplace_back([this] {work();});
+    }
+}
+
+Series_prefetcher::~Series_prefetcher() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopped = true;
+    }
+    m_job_added.notify_all();
+
+    for(std::thread& worker : m_workers) {
+        worker.join();
+    }
+}
+
+void Series_prefetcher::setup_event_callbacks() {
+    // Parsed files would refer to the values of the replaced files.
+    m_files.file_saved.add_callback([this] {clear();});
+    m_files.all_files_edited.add_callback([this] {clear();});
+    m_files.file_removed.add_callback([this] (const Dicom_file* file) {remove(file);});
+}
+
+void Series_prefetcher::prefetch(const std::vector<Dicom_file*>& files) {
+    const uint64_t cache_generation = m_frame_cache.get_generation();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
+    m_wanted_files.clear();
+
+    for(Dicom_file* file : files) {
+        if(file->has_unsaved_changes()) {
+            continue;
+        }
+        m_wanted_files.insert(file);
+
+        if(file->is_fully_loaded()) {
+            m_parsed_files.erase(file);
+        }
+        const bool parse = !file->is_fully_loaded() && m_parsed_files.count(file) == 0;
+
+        if(parse || m_frame_cache.find(*file, 0) == nullptr) {
+            m_jobs.push_back({file, file->get_path(), file->get_max_read_length(), parse, cache_generation});
+        }
+    }
+    for(auto it = m_parsed_files.begin(); it != m_parsed_files.end();) {
+        it = m_wanted_files.count(it->first) > 0 ? std::next(it) : m_parsed_files.erase(it);
+    }
+    m_job_added.notify_all();
+}
+
+std::unique_ptr<DcmFileFormat> Series_prefetcher::take_parsed_file(const Dicom_file& file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_parsed_files.find(&file);
+
+    if(it == m_parsed_files.end()) {
+        return nullptr;
+    }
+    std::unique_ptr<DcmFileFormat> parsed_file = std::move(it->second);
+    m_parsed_files.erase(it);
+    return parsed_file;
+}
+
+void Series_prefetcher::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_jobs.clear();
+    m_wanted_files.clear();
+    m_parsed_files.clear();
+}
+
+void Series_prefetcher::wait() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job_done.wait(lock, [this] {return m_jobs.empty() && m_running_count == 0;});
+}
+
+void Series_prefetcher::remove(const Dicom_file* file) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_wanted_files.erase(file);
+    m_parsed_files.erase(file);
+}
+
+void Series_prefetcher::work() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while(true) {
+        m_job_added.wait(lock, [this] {return m_stopped || !m_jobs.empty();});
+
+        if(m_stopped) {
+            return;
+        }
+        const Job job = m_jobs.front();
+        m_jobs.pop_front();
+        ++m_running_count;
+        lock.unlock();
+        run(job);
+        lock.lock();
+        --m_running_count;
+        m_job_done.notify_all();
+    }
+}
+
+void Series_prefetcher::run(const Job& job) {
+    try {
+        // The worker's own parse is used for rendering even if the file is loaded,
+        // since datasets cannot be read from several threads.
+        std::unique_ptr<DcmFileFormat> parsed_file = Dicom_file::parse_file(job.path, job.max_read_length);
+
+        if(m_frame_cache.find(*job.file, 0) == nullptr) {
+            m_frame_cache.insert(*job.file, 0, std::make_shared<const Rendered_frame>(
+                Frame_cache::render_frame(*parsed_file->getDataset(), 0)), job.cache_generation);
+        }
+        if(job.parse) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            if(m_wanted_files.count(job.file) > 0) {
+                m_parsed_files[job.file] = std::move(parsed_file);
+            }
+        }
+    }
+    catch(const std::exception& e) {
+        Log::debug("Failed to prefetch file: " + job.path.string() + "\nReason: " + std::string(e.what()));
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/** Parses files and renders their first frame on background threads, so
+ *  making a file current needs neither. The frames go to the frame cache, the
+ *  parsed files are handed over by take_parsed_file. Files with unsaved
+ *  changes are not prefetched. All functions must be called on the thread
+ *  that owns the files.
+ */
+class Series_prefetcher
+{
+public:
+    Series_prefetcher(Dicom_files&, Frame_cache&);
+    ~Series_prefetcher();
+    Series_prefetcher(const Series_prefetcher&) = delete;
+    Series_prefetcher& operator=(const Series_prefetcher&) = delete;
+
+    /** Replace the files to prefetch, in the order given. Pending files and
+     *  parsed files that are not in the list are dropped. */
+    void prefetch(const std::vector<Dicom_file*>&);
+    /** Returns the parsed file for Dicom_file::load_fully, or null if it is not parsed yet. */
+    std::unique_ptr<DcmFileFormat> take_parsed_file(const Dicom_file&);
+    /** Drop all pending and parsed files. */
+    void clear();
+    /** Wait until the pending files are done. */
+    void wait();
+
+private:
+    struct Job
+    {
+        const Dicom_file* file;
+        fs::path path;
+        Uint32 max_read_length;
+        bool parse;
+        uint64_t cache_generation;
+    };
+
+    void setup_event_callbacks();
+    void work();
+    void run(const Job&);
+    void remove(const Dicom_file*);
+
+    Dicom_files& m_files;
+    Frame_cache& m_frame_cache;
+    std::mutex m_mutex;
+    std::condition_variable m_job_added;
+    std::condition_variable m_job_done;
+    std::deque<Job> m_jobs;
+    /** Files of the latest prefetch call. Results for other files are dropped. */
+    std::unordered_set<const Dicom_file*> m_wanted_files;
+    std::unordered_map<const Dicom_file*, std::unique_ptr<DcmFileFormat>> m_parsed_files;
+    size_t m_running_count;
+    bool m_stopped;
+    std::vector<std::thread> m_workers;
+};
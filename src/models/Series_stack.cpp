@@ -0,0 +1,152 @@
+#include "models/Series_stack.h"
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <vector>
+
+struct Slice_key
+{
+    Dicom_file* file;
+    bool has_position;
+    double position;
+    Sint32 instance_number;
+};
+
+/** Returns true if the change edits an attribute that decides the series or the order of its slices. */
+static bool affects_order(const Dataset_change& change) {
+    return std::any_of(change.top_level_tags.begin(), change.top_level_tags.end(), [] (const DcmTagKey& tag) {
+        return tag == DCM_SeriesInstanceUID || tag == DCM_InstanceNumber
+            || tag == DCM_ImagePositionPatient || tag == DCM_ImageOrientationPatient;
+    });
+}
+
+static std::string get_series_instance_uid(Dicom_file& file) {
+    OFString uid;
+    file.get_dataset().findAndGetOFString(DCM_SeriesInstanceUID, uid);
+    return uid.c_str();
+}
+
+template<size_t N>
+static bool get_values(DcmItem& dataset, const DcmTagKey& tag, std::array<double, N>& values) {
+    for(size_t i = 0; i < N; ++i) {
+        if(dataset.findAndGetFloat64(tag, values[i], static_cast<unsigned long>(i)).bad()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Position of the slice along its normal, the cross product of the row and column directions. */
+static bool get_slice_position(DcmItem& dataset, double& position) {
+    std::array<double, 3> image_position{};
+    std::array<double, 6> orientation{};
+
+    if(!get_values(dataset, DCM_ImagePositionPatient, image_position)
+        || !get_values(dataset, DCM_ImageOrientationPatient, orientation)) {
+        return false;
+    }
+    const std::array<double, 3> normal{
+        orientation[1] * orientation[5] - orientation[2] * orientation[4],
+        orientation[2] * orientation[3] - orientation[0] * orientation[5],
+        orientation[0] * orientation[4] - orientation[1] * orientation[3]};
+    position = image_position[0] * normal[0] + image_position[1] * normal[1] + image_position[2] * normal[2];
+    return true;
+}
+
+static Slice_key get_slice_key(Dicom_file& file) {
+    DcmDataset& dataset = file.get_dataset();
+    Slice_key key{&file, false, 0.0, std::numeric_limits<Sint32>::max()};
+    key.has_position = get_slice_position(dataset, key.position);
+    dataset.findAndGetSint32(DCM_InstanceNumber, key.instance_number);
+    return key;
+}
+
+Series_stack::Series_stack(Dicom_files& files, Dataset_model& dataset_model)
+    : m_files(files),
+      m_outdated(true) {
+    m_files.files_added.add_callback([this] {m_outdated = true;});
+    m_files.file_removed.add_callback([this] (const Dicom_file*) {m_outdated = true;});
+    m_files.all_files_edited.add_callback([this] {m_outdated = true;});
+    dataset_model.dataset_changed.add_callback([this] (const Dataset_change& change) {
+        if(affects_order(change)) {
+            m_outdated = true;
+        }
+    });
+}
+
+Dicom_file* Series_stack::get_neighbor(Dicom_file& file, int steps) {
+    update(file);
+    const auto position = static_cast<long long>(m_positions.at(&file)) + steps;
+    const auto last = static_cast<long long>(m_stack.size()) - 1;
+    return m_stack[static_cast<size_t>(std::clamp(position, 0ll, last))];
+}
+
+std::vector<Dicom_file*> Series_stack::get_neighbors(Dicom_file& file, size_t distance, int direction) {
+    update(file);
+    const size_t position = m_positions.at(&file);
+    const int sign = direction < 0 ? -1 : 1;
+    std::vector<Dicom_file*> neighbors;
+
+    for(size_t i = 1; i <= distance; ++i) {
+        for(int side : {sign, -sign}) {
+            if(side > 0 && position + i < m_stack.size()) {
+                neighbors.push_back(m_stack[position + i]);
+            }
+            else if(side < 0 && i <= position) {
+                neighbors.push_back(m_stack[position - i]);
+            }
+        }
+    }
+    return neighbors;
+}
+
+const std::vector<Dicom_file*>& Series_stack::get_files(Dicom_file& file) {
+    update(file);
+    return m_stack;
+}
+
+size_t Series_stack::get_position(Dicom_file& file) {
+    update(file);
+    return m_positions.at(&file);
+}
+
+void Series_stack::update(Dicom_file& file) {
+    const std::string series_instance_uid = get_series_instance_uid(file);
+
+    if(!m_outdated && series_instance_uid == m_series_instance_uid && m_positions.count(&file) > 0) {
+        return;
+    }
+    std::vector<Slice_key> keys;
+
+    // Files without a series are not stacked with each other.
+    if(series_instance_uid.empty()) {
+        keys.push_back(get_slice_key(file));
+    }
+    else {
+        for(auto& other : m_files.get_files()) {
+            if(get_series_instance_uid(*other) == series_instance_uid) {
+                keys.push_back(get_slice_key(*other));
+            }
+        }
+    }
+    const bool all_have_position = std::all_of(keys.begin(), keys.end(),
+        [] (const Slice_key& key) {return key.has_position;});
+
+    std::stable_sort(keys.begin(), keys.end(), [all_have_position] (const Slice_key& a, const Slice_key& b) {
+        if(all_have_position && a.position != b.position) {
+            return a.position < b.position;
+        }
+        return a.instance_number < b.instance_number;
+    });
+    m_series_instance_uid = series_instance_uid;
+    m_stack.clear();
+    m_positions.clear();
+
+    for(const Slice_key& key : keys) {
+        m_positions[key.file] = m_stack.size();
+        m_stack.push_back(key.file);
+    }
+    m_outdated = false;
+}
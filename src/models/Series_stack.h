@@ -0,0 +1,38 @@
+#pragma once
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** The open files of a series in slice order. Files are sorted by their
+ *  position along the slice normal if all of them have Image Position and
+ *  Image Orientation (Patient), otherwise by Instance Number. The order is
+ *  kept until files are added or closed, an attribute that the order depends
+ *  on is edited, or a file of another series is used.
+ */
+class Series_stack
+{
+public:
+    Series_stack(Dicom_files&, Dataset_model&);
+
+    /** Returns the file steps slices away, clamped to the ends of the stack. */
+    Dicom_file* get_neighbor(Dicom_file&, int steps);
+    /** Returns up to distance files on each side, nearest first. At each
+     *  distance the file in direction comes first. */
+    std::vector<Dicom_file*> get_neighbors(Dicom_file&, size_t distance, int direction);
+    /** Returns the sorted files of the series of the file. */
+    const std::vector<Dicom_file*>& get_files(Dicom_file&);
+    size_t get_position(Dicom_file&);
+
+private:
+    void update(Dicom_file&);
+
+    Dicom_files& m_files;
+    std::string m_series_instance_uid;
+    std::vector<Dicom_file*> m_stack;
+    std::unordered_map<const Dicom_file*, size_t> m_positions;
+    bool m_outdated;
+};
@@ -0,0 +1,36 @@
+#include "models/Stack_tool.h"
+
+#include "ui/Gui_util.h"
+
+#include <QMouseEvent>
+
+const int pixels_per_slice{8};
+
+Stack_tool::Stack_tool()
+    : m_latest_y(0),
+      m_distance(0),
+      m_steps(0) {}
+
+bool Stack_tool::mouse_move(const QMouseEvent& event) {
+    if(!Gui_util::is_left_mouse_pressed(event)) {
+        return false;
+    }
+    m_distance += event.y() - m_latest_y;
+    m_latest_y = event.y();
+    const int steps = m_distance / pixels_per_slice;
+    m_distance -= steps * pixels_per_slice;
+    m_steps += steps;
+    return steps != 0;
+}
+
+bool Stack_tool::mouse_press(const QMouseEvent& event) {
+    m_latest_y = event.y();
+    m_distance = 0;
+    return false;
+}
+
+int Stack_tool::take_steps() {
+    const int steps = m_steps;
+    m_steps = 0;
+    return steps;
+}
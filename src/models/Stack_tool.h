@@ -0,0 +1,21 @@
+#pragma once
+#include "models/Tool.h"
+
+/** Steps through the slices of a series by dragging. Dragging down moves to
+ *  the next slice. */
+class Stack_tool : public Tool
+{
+public:
+    Stack_tool();
+
+    bool mouse_move(const QMouseEvent&) override;
+    bool mouse_press(const QMouseEvent&) override;
+    /** Returns the slices dragged since the last call. */
+    int take_steps();
+
+private:
+    int m_latest_y;
+    /** Drag distance not yet counted as a step. */
+    int m_distance;
+    int m_steps;
+};
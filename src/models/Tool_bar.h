@@ -5,7 +5,9 @@ class Tool_bar
 public:
     enum Tool {
         pan,
-        zoom
+        zoom,
+        window_level,
+        stack
     };
 
     Tool_bar();
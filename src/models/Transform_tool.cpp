@@ -4,13 +4,18 @@
 
 #include <QMouseEvent>
 #include <QTransform>
+#include <algorithm>
 
 const double max_scaling{3.0};
 const double min_scaling{0.2};
+/* The smallest size, in pixels, that the longer side of a large image is zoomed
+*  out to. */
+const double min_scaled_size{256.0};
 
 Transform_tool::Transform_tool()
     : m_mode(Mode::translate),
-      m_scaling(1.0) {}
+      m_scaling(1.0),
+      m_min_scaling(min_scaling) {}
 
 bool Transform_tool::mouse_move(const QMouseEvent& event) {
     if(!Gui_util::is_left_mouse_pressed(event)) {
@@ -32,6 +37,11 @@ bool Transform_tool::mouse_press(const QMouseEvent& event) {
     return false;
 }
 
+void Transform_tool::set_image_size(QSize size) {
+    const int longer_side = std::max(size.width(), size.height());
+    m_min_scaling = longer_side > 0 ? std::min(min_scaling, min_scaled_size / longer_side) : min_scaling;
+}
+
 QTransform Transform_tool::get_transform() const {
     QTransform transform;
     transform.translate(m_translation.x(), m_translation.y());
@@ -49,8 +59,8 @@ void Transform_tool::mouse_move_scale(double y) {
     if(new_scaling > max_scaling) {
         scaling_delta = max_scaling - m_scaling;
     }
-    else if(new_scaling < min_scaling) {
-        scaling_delta = min_scaling - m_scaling;
+    else if(new_scaling < m_min_scaling) {
+        scaling_delta = m_min_scaling - m_scaling;
     }
     m_scaling += scaling_delta;
     /* Adjust the translation so the point m_image_point is fixed while the
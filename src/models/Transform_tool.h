@@ -2,6 +2,7 @@
 #include "models/Tool.h"
 
 #include <QPointF>
+#include <QSize>
 #include <QTransform>
 
 class Transform_tool : public Tool
@@ -14,6 +15,8 @@ public:
     QTransform get_transform() const;
     void set_translate_mode() {m_mode = Mode::translate;}
     void set_scale_mode() {m_mode = Mode::scale;}
+    /** Lets a large image be zoomed out until it is a few hundred pixels wide. */
+    void set_image_size(QSize);
 
 private:
     void mouse_move_translate(QPointF);
@@ -28,6 +31,7 @@ private:
     Mode m_mode;
     QPointF m_translation;
     double m_scaling;
+    double m_min_scaling;
     QPointF m_latest_point;
     QPointF m_image_point;
 };
@@ -0,0 +1,40 @@
+#include "models/Window_level_tool.h"
+
+#include "ui/Gui_util.h"
+
+#include <QMouseEvent>
+#include <algorithm>
+
+const double steps_per_width{256.0};
+const double min_width{1.0};
+
+Window_level_tool::Window_level_tool()
+    : m_center(0.0),
+      m_width(min_width),
+      m_step(min_width / steps_per_width) {}
+
+bool Window_level_tool::mouse_move(const QMouseEvent& event) {
+    if(!Gui_util::is_left_mouse_pressed(event)) {
+        return false;
+    }
+    const QPointF delta = event.pos() - m_latest_point;
+    m_latest_point = event.pos();
+
+    if(delta.isNull()) {
+        return false;
+    }
+    m_width = std::max(m_width + delta.x() * m_step, min_width);
+    m_center -= delta.y() * m_step;
+    return true;
+}
+
+bool Window_level_tool::mouse_press(const QMouseEvent& event) {
+    m_latest_point = event.pos();
+    return false;
+}
+
+void Window_level_tool::set_window(double center, double width) {
+    m_center = center;
+    m_width = std::max(width, min_width);
+    m_step = m_width / steps_per_width;
+}
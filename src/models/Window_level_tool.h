@@ -0,0 +1,26 @@
+#pragma once
+#include "models/Tool.h"
+
+#include <QPointF>
+
+/** Adjusts the window by dragging. Moving right widens the window and moving
+ *  up raises its center. */
+class Window_level_tool : public Tool
+{
+public:
+    Window_level_tool();
+
+    bool mouse_move(const QMouseEvent&) override;
+    bool mouse_press(const QMouseEvent&) override;
+    double get_center() const {return m_center;}
+    double get_width() const {return m_width;}
+    /** Set the window. Mouse movement is scaled to the width, so images with
+     *  any range of values take about the same movement to adjust. */
+    void set_window(double center, double width);
+
+private:
+    double m_center;
+    double m_width;
+    double m_step;
+    QPointF m_latest_point;
+};
@@ -7,9 +7,15 @@
 #include "ui/edit_value_dialog/Edit_value_presenter.h"
 #include "ui/edit_value_dialog/IEdit_value_view.h"
 
+#include <algorithm>
+#include <dcmtk/dcmdata/dcfcache.h>
 #include <exception>
+#include <fstream>
 #include <QModelIndex>
 #include <QPoint>
+#include <vector>
+
+const Uint32 copy_chunk_size = 1024 * 1024;
 
 Dataset_presenter::Dataset_presenter(IDataset_view& view, Dataset_model& dataset_model)
     : m_view(view),
@@ -83,17 +89,24 @@ void Dataset_presenter::save_value_to_file(const QModelIndex& index) {
     if(file_path.empty()) {
         return;
     }
-    const auto length = element->getLength();
-    std::vector<char> buffer(length);
-    OFCondition status = element->getPartialValue(buffer.data(), 0, length, nullptr, EBO_LittleEndian);
-
-    if(status.bad()) {
-        m_view.show_error("Save failed", "Failed to get the data element value.\n"
-            "Reason: " + std::string(status.text()));
-        return;
-    }
     std::ofstream file(file_path, std::ios_base::binary);
-    file.write(buffer.data(), length);
+    const Uint32 length = element->getLength();
+    std::vector<char> buffer(std::min(length, copy_chunk_size));
+    DcmFileCache cache;
+
+    /* Copy the value in chunks so values that were left on disk are never
+    *  loaded into memory as a whole. */
+    for(Uint32 offset = 0; offset < length && file.good(); offset += static_cast<Uint32>(buffer.size())) {
+        const Uint32 chunk_size = std::min(length - offset, copy_chunk_size);
+        OFCondition status = element->getPartialValue(buffer.data(), offset, chunk_size, &cache, EBO_LittleEndian);
+
+        if(status.bad()) {
+            m_view.show_error("Save failed", "Failed to get the data element value.\n"
+                "Reason: " + std::string(status.text()));
+            return;
+        }
+        file.write(buffer.data(), chunk_size);
+    }
 
     if(!file.good()) {
         m_view.show_error("Save failed", "Failed to save the data element value.");
@@ -48,9 +48,20 @@ void Edit_all_files_presenter::apply() {
     }
     std::vector<std::string> file_errors;
     const auto mode = m_view.mode();
+    DcmTagKey top_level_tag;
+    bool track_changes = true;
+
+    try {
+        top_level_tag = Dicom_util::get_top_level_tag(tag_path);
+    }
+    catch(const std::exception&) {
+        track_changes = false;
+    }
 
     for(auto& file : m_files.get_files()) {
         try {
+            m_files.load_fully(*file);
+
             if(mode == IEdit_all_files_view::Mode::set) {
                 Dicom_util::set_element(tag_path, value, true, file->get_dataset());
             }
@@ -72,7 +83,12 @@ void Edit_all_files_presenter::apply() {
             file_errors.push_back(file->get_path().string() +
                 "\nReason: " + std::string(e.what()));
         }
-        file->set_unsaved_changes(true);
+        if(track_changes) {
+            file->mark_modified(top_level_tag);
+        }
+        else {
+            file->set_unsaved_changes(true);
+        }
     }
     m_files.all_files_edited();
 
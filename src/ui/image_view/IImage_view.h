@@ -1,8 +1,10 @@
 #pragma once
+#include "models/Image_pyramid.h"
 #include "ui/IView.h"
 
 #include <QMouseEvent>
 #include <QTransform>
+#include <chrono>
 #include <cstdint>
 #include <eventi/Event.h>
 #include <string>
@@ -10,11 +12,43 @@
 class IImage_view : public IView
 {
 public:
+    enum class Pixel_format {
+        /** Opaque pixels as 0xffRRGGBB, drawn without conversion. */
+        rgb32,
+        /** 8-bit interleaved RGB, converted once in set_image. */
+        rgb888,
+        /** 16-bit gray, converted once in set_image. Only for callers that need the precision. */
+        gray16
+    };
+
     eventi::Event<> draw_requested;
     eventi::Event<QMouseEvent*> mouse_moved;
     eventi::Event<QMouseEvent*> mouse_pressed;
+    eventi::Event<> next_frame_requested;
+    eventi::Event<> previous_frame_requested;
+    eventi::Event<> play_toggled;
+    eventi::Event<> timer_elapsed;
+    /** Slices to step through the series, positive towards the next slice. */
+    eventi::Event<int> slice_scrolled;
 
     virtual void update() = 0;
-    virtual void draw(const uint8_t* pixel_data, int width, int height, bool monochrome, const QTransform&) = 0;
+    /** Repaint after delay. A new call replaces a scheduled repaint. */
+    virtual void schedule_update(std::chrono::milliseconds delay) = 0;
+    /** Returns the refresh rate of the screen showing the view, in Hz. */
+    virtual double get_refresh_rate() const = 0;
+    /** Convert the image for display. Rows are packed without padding. The pixel
+     *  data is copied, so it can be freed after the call. */
+    virtual void set_image(const uint8_t* pixel_data, int width, int height, Pixel_format) = 0;
+    /** Show an image that is too large to convert at once. Only the tiles that are
+     *  drawn are requested from source, which must keep its data alive. A new
+     *  call, e.g. after the window changed, drops the tiles of the previous one. */
+    virtual void set_tiled_image(int width, int height, Image_pyramid::Tile_source) = 0;
+    /** Paint the image from set_image. Called on draw_requested. */
+    virtual void draw(const QTransform&) = 0;
     virtual void show_error(const std::string&) = 0;
+    /** Paint the frame number over the image. Called on draw_requested. */
+    virtual void show_frame_number(unsigned long frame_number, unsigned long frame_count) = 0;
+    /** Fire timer_elapsed repeatedly until stop_timer. */
+    virtual void start_timer(std::chrono::milliseconds interval) = 0;
+    virtual void stop_timer() = 0;
 };
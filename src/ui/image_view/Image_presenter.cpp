@@ -1,88 +1,354 @@
 #include "ui/image_view/Image_presenter.h"
 
+#include "common/Window_level.h"
+#include "logging/Log.h"
 #include "models/Dataset_model.h"
 #include "models/Tool_bar.h"
 #include "ui/image_view/IImage_view.h"
 
-#include <dcmtk/dcmdata/dcitem.h>
-#include <dcmtk/dcmimage/diregist.h>
-#include <dcmtk/dcmimgle/dcmimage.h>
+#include <dcmtk/dcmdata/dcxfer.h>
 #include <eventi/Callback_ref.h>
+#include <QRect>
+#include <QSize>
 #include <QTransform>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <optional>
 #include <string>
+#include <utility>
+#include <variant>
+
+const std::chrono::milliseconds slow_window_time{5};
+const std::chrono::microseconds default_frame_interval{16667};
+const std::chrono::seconds frame_stats_interval{1};
+const int max_untiled_size{4096};
+const uint32_t opaque_alpha{0xff000000};
 
 Image_presenter::Image_presenter(IImage_view& view,
+    Dicom_files& files,
     Dataset_model& dataset_model,
+    Frame_cache& frame_cache,
+    Frame_decoder& frame_decoder,
+    Series_navigator& series_navigator,
     Tool_bar& tool_bar)
     : m_view(view),
+      m_files(files),
       m_dataset_model(dataset_model),
-      m_tool_bar(tool_bar) {
+      m_frame_cache(frame_cache),
+      m_frame_decoder(frame_decoder),
+      m_series_navigator(series_navigator),
+      m_tool_bar(tool_bar),
+      m_frame_index(0),
+      m_frame_count(1),
+      m_reset_window(true),
+      m_stepping_slices(false),
+      m_window_changed(false),
+      m_frame_pacer(default_frame_interval),
+      m_stats_start(Frame_pacer::Clock::now()),
+      m_cine_player(frame_cache),
+      m_decode_started(false) {
     setup_event_callbacks();
 }
 
 void Image_presenter::setup_event_callbacks() {
-    eventi::Callback_ref callback = m_dataset_model.dataset_changed.add_callback([this] {update();});
+    eventi::Callback_ref callback = m_dataset_model.dataset_changed.add_callback(
+        [this] (const Dataset_change& change) {on_dataset_changed(change);});
+    m_scoped_callbacks.add_to_scope(callback);
+    callback = m_files.file_saved.add_callback([this] {on_file_saved();});
     m_scoped_callbacks.add_to_scope(callback);
 
     m_view.draw_requested.add_callback([this] {draw();});
     m_view.mouse_moved.add_callback([this] (QMouseEvent* event) {on_mouse_move(event);});
     m_view.mouse_pressed.add_callback([this] (QMouseEvent* event) {on_mouse_press(event);});
+    m_view.next_frame_requested.add_callback([this] {show_next_frame();});
+    m_view.previous_frame_requested.add_callback([this] {show_previous_frame();});
+    m_view.play_toggled.add_callback([this] {toggle_cine();});
+    m_view.timer_elapsed.add_callback([this] {on_timer();});
+    m_view.slice_scrolled.add_callback([this] (int steps) {step_slices(steps);});
+}
+
+void Image_presenter::on_dataset_changed(const Dataset_change& change) {
+    // Frame_cache drops the frames of the file itself.
+    if(change.reset || change.affects_image()) {
+        stop_cine();
+        m_frame_decoder.cancel();
+        m_decode_started = false;
+        m_reset_window = !m_stepping_slices;
+
+        if(change.reset) {
+            m_frame_index = 0;
+            m_frame_count = 1;
+        }
+        update();
+    }
+}
+
+void Image_presenter::on_file_saved() {
+    // The workers read values left on disk, which the save may have moved.
+    stop_cine();
+    m_frame_decoder.cancel();
+    m_decode_started = false;
+    update();
 }
 
 void Image_presenter::update() {
     m_view.update();
 }
 
-static const uint8_t* get_pixel_data(DicomImage& image) {
-    int bits_per_sample = image.isMonochrome() ? 16 : 8;
-    return static_cast<const uint8_t*>(image.getOutputData(bits_per_sample));
-}
+void Image_presenter::schedule_update() {
+    const double refresh_rate = m_view.get_refresh_rate();
 
-static bool is_image_supported(const DicomImage& image) {
-    auto photo_interp = image.getPhotometricInterpretation();
-    return photo_interp == EPI_Monochrome1
-        || photo_interp == EPI_Monochrome2
-        || photo_interp == EPI_PaletteColor
-        || photo_interp == EPI_RGB;
+    if(refresh_rate > 0.0) {
+        m_frame_pacer.set_frame_interval(std::chrono::microseconds(static_cast<long long>(1e6 / refresh_rate)));
+    }
+    const std::optional<std::chrono::microseconds> delay = m_frame_pacer.request_frame(Frame_pacer::Clock::now());
+
+    if(delay) {
+        m_view.schedule_update(std::chrono::ceil<std::chrono::milliseconds>(*delay));
+    }
 }
 
 void Image_presenter::draw() {
-    DcmItem* dataset = m_dataset_model.get_dataset();
+    m_frame_pacer.start_frame(Frame_pacer::Clock::now());
+    draw_frame();
+    const auto now = Frame_pacer::Clock::now();
+    m_frame_pacer.finish_frame(now);
+    log_frame_stats(now);
+}
+
+void Image_presenter::log_frame_stats(Frame_pacer::Clock::time_point now) {
+    if(now - m_stats_start < frame_stats_interval) {
+        return;
+    }
+    const Frame_stats stats = m_frame_pacer.take_stats();
+    m_stats_start = now;
+    const auto to_ms = [] (std::chrono::microseconds time) {return std::to_string(time.count() / 1000);};
+
+    Log::debug("Drew " + std::to_string(stats.frame_count) + " image frames, average " +
+        to_ms(stats.total_time / static_cast<long long>(std::max<unsigned long>(1, stats.frame_count))) +
+        " ms, max " + to_ms(stats.max_time) + " ms, " + std::to_string(stats.over_budget_count) +
+        " over the " + to_ms(m_frame_pacer.get_frame_interval()) + " ms budget");
+}
+
+void Image_presenter::draw_frame() {
+    Dicom_file* file = m_dataset_model.get_file();
+
+    if(file == nullptr) {
+        return;
+    }
+    // During cine the frames are set by on_timer.
+    if(!m_cine_player.is_playing()) {
+        std::shared_ptr<const Rendered_frame> frame = m_frame_cache.get_frame(*file, m_frame_index);
+
+        if(!frame->error.empty()) {
+            m_view.show_error(frame->error);
+            return;
+        }
+        // The view keeps the converted image, so only the transform changes between repaints.
+        if(frame != m_frame) {
+            set_frame(frame);
+        }
+        if(!m_decode_started) {
+            decode_remaining_frames(*file);
+        }
+    }
+    if(m_window_changed && m_frame != nullptr && m_frame->monochrome) {
+        apply_window();
+    }
+    m_view.draw(m_transform_tool.get_transform());
+
+    if(m_frame_count > 1) {
+        m_view.show_frame_number(m_frame_index + 1, m_frame_count);
+    }
+}
+
+/** Frames larger than this are converted a tile at a time by the view, from
+ *  the frame's own data, instead of into a display copy of the whole frame. */
+static bool is_tiled(const Rendered_frame& frame) {
+    return frame.width > max_untiled_size || frame.height > max_untiled_size;
+}
+
+static size_t get_offset(const Rendered_frame& frame, int x, int y) {
+    return static_cast<size_t>(y) * static_cast<size_t>(frame.width) + static_cast<size_t>(x);
+}
+
+static Image_pyramid::Tile_source make_window_source(std::shared_ptr<const Rendered_frame> frame,
+    double center, double width) {
+    return [frame, center, width] (const QRect& rect, uint32_t* pixels, size_t stride) {
+        std::visit([&] (const auto& values) {
+            for(int y = 0; y < rect.height(); ++y) {
+                Window_level::apply_rgb32(values.data() + get_offset(*frame, rect.x(), rect.y() + y),
+                    static_cast<size_t>(rect.width()), center, width, frame->inverse,
+                    pixels + static_cast<size_t>(y) * stride);
+            }
+        }, frame->modality_values);
+    };
+}
+
+static Image_pyramid::Tile_source make_color_source(std::shared_ptr<const Rendered_frame> frame) {
+    return [frame] (const QRect& rect, uint32_t* pixels, size_t stride) {
+        for(int y = 0; y < rect.height(); ++y) {
+            const uint8_t* rgb = frame->pixel_data.data() + get_offset(*frame, rect.x(), rect.y() + y) * 3;
+            uint32_t* row = pixels + static_cast<size_t>(y) * stride;
+
+            for(int x = 0; x < rect.width(); ++x, rgb += 3) {
+                row[x] = opaque_alpha | uint32_t{rgb[0]} << 16 | uint32_t{rgb[1]} << 8 | rgb[2];
+            }
+        }
+    };
+}
+
+void Image_presenter::set_frame(std::shared_ptr<const Rendered_frame> frame) {
+    m_frame = std::move(frame);
+    m_frame_count = m_frame->frame_count;
+    m_transform_tool.set_image_size(QSize(m_frame->width, m_frame->height));
+
+    if(m_frame->monochrome) {
+        if(m_reset_window) {
+            m_window_level_tool.set_window(m_frame->window_center, m_frame->window_width);
+            m_reset_window = false;
+        }
+        apply_window();
+    }
+    else if(is_tiled(*m_frame)) {
+        m_view.set_tiled_image(m_frame->width, m_frame->height, make_color_source(m_frame));
+    }
+    else {
+        m_view.set_image(m_frame->pixel_data.data(), m_frame->width, m_frame->height,
+            IImage_view::Pixel_format::rgb888);
+    }
+}
+
+void Image_presenter::apply_window() {
+    const auto start_time = std::chrono::steady_clock::now();
+    m_window_changed = false;
 
-    if(dataset == nullptr) {
+    // Only the tiles that are drawn are windowed.
+    if(is_tiled(*m_frame)) {
+        m_display_data = std::vector<uint32_t>();
+        m_view.set_tiled_image(m_frame->width, m_frame->height, make_window_source(m_frame,
+            m_window_level_tool.get_center(), m_window_level_tool.get_width()));
         return;
     }
-    DicomImage image(dataset, EXS_Unknown);
+    std::visit([this] (const auto& values) {
+        m_display_data.resize(values.size());
+        Window_level::apply_rgb32(values.data(), values.size(), m_window_level_tool.get_center(),
+            m_window_level_tool.get_width(), m_frame->inverse, m_display_data.data());
+    }, m_frame->modality_values);
+    m_view.set_image(reinterpret_cast<const uint8_t*>(m_display_data.data()), m_frame->width,
+        m_frame->height, IImage_view::Pixel_format::rgb32);
+
+    const auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+    if(elapsed > slow_window_time) {
+        Log::debug("Windowing took " + std::to_string(
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()) + " ms");
+    }
+}
+
+void Image_presenter::show_next_frame() {
+    stop_cine();
+    m_frame_index = (m_frame_index + 1) % m_frame_count;
+    update();
+}
+
+void Image_presenter::show_previous_frame() {
+    stop_cine();
+    m_frame_index = (m_frame_index + m_frame_count - 1) % m_frame_count;
+    update();
+}
+
+void Image_presenter::toggle_cine() {
+    if(m_cine_player.is_playing()) {
+        stop_cine();
+        return;
+    }
+    Dicom_file* file = m_dataset_model.get_file();
+
+    if(file == nullptr || m_frame_count < 2) {
+        return;
+    }
+    const double frames_per_second = Cine_player::get_frame_rate(file->get_dataset());
+    m_cine_player.play(*file, (m_frame_index + 1) % m_frame_count, m_frame_count, frames_per_second);
+    // Polling twice per frame keeps the shown frame within half a frame of its due time.
+    const auto interval = std::chrono::milliseconds(static_cast<int>(500.0 / frames_per_second));
+    m_view.start_timer(std::max(interval, std::chrono::milliseconds(1)));
+}
+
+void Image_presenter::stop_cine() {
+    if(m_cine_player.is_playing()) {
+        m_cine_player.stop();
+        m_view.stop_timer();
+    }
+}
 
-    if(!is_image_supported(image)) {
-        m_view.show_error("Photometric Interpretation not supported");
+void Image_presenter::on_timer() {
+    Cine_player::Frame due_frame = m_cine_player.take_due_frame();
+
+    if(due_frame.frame == nullptr) {
         return;
     }
-    image.setMinMaxWindow();
-    const uint8_t* pixel_data = get_pixel_data(image);
+    m_frame_index = due_frame.index;
+
+    // The error is shown by draw, which renders the frame again from the cache.
+    if(!due_frame.frame->error.empty()) {
+        stop_cine();
+    }
+    else if(due_frame.frame != m_frame) {
+        set_frame(std::move(due_frame.frame));
+    }
+    update();
+}
+
+void Image_presenter::decode_remaining_frames(Dicom_file& file) {
+    m_decode_started = true;
 
-    if(pixel_data == nullptr) {
-        std::string status = DicomImage::getString(image.getStatus());
-        m_view.show_error(status);
+    // Uncompressed frames are read one at a time from the file, which is fast enough.
+    if(m_frame_count < 2 || !DcmXfer(file.get_dataset().getOriginalXfer()).isEncapsulated()) {
         return;
     }
-    auto width = static_cast<int>(image.getWidth());
-    auto height = static_cast<int>(image.getHeight());
-    bool monochrome = image.isMonochrome();
-    m_view.draw(pixel_data, width, height, monochrome, m_transform_tool.get_transform());
+    // Frames beyond half the cache budget would evict the first ones, or frames of other files.
+    const size_t frame_size = std::max<size_t>(1, m_frame->get_data_size());
+    const auto max_count = static_cast<unsigned long>(m_frame_cache.get_budget() / 2 / frame_size);
+    m_frame_decoder.decode(file, m_frame_index + 1, std::min(m_frame_count - 1, max_count), m_frame_count);
+}
+
+void Image_presenter::step_slices(int steps) {
+    m_stepping_slices = true;
+    try {
+        m_series_navigator.step(steps);
+    }
+    catch(const std::exception& e) {
+        Log::error("Failed to step to the next slice.\nReason: " + std::string(e.what()));
+    }
+    m_stepping_slices = false;
 }
 
 void Image_presenter::on_mouse_move(QMouseEvent* event) {
-    bool has_changed = m_transform_tool.mouse_move(*event);
+    bool has_changed = get_selected_tool().mouse_move(*event);
 
-    if(has_changed) {
-        update();
+    if(!has_changed) {
+        return;
+    }
+    if(m_tool_bar.get_selected_tool() == Tool_bar::stack) {
+        step_slices(m_stack_tool.take_steps());
+        return;
+    }
+    // Tools keep the combined effect of the moves, which the next repaint shows.
+    if(m_tool_bar.get_selected_tool() == Tool_bar::window_level) {
+        if(m_frame == nullptr || !m_frame->monochrome) {
+            return;
+        }
+        m_window_changed = true;
     }
+    schedule_update();
 }
 
 void Image_presenter::on_mouse_press(QMouseEvent* event) {
     set_tool();
-    bool has_changed = m_transform_tool.mouse_press(*event);
+    bool has_changed = get_selected_tool().mouse_press(*event);
 
     if(has_changed) {
         update();
@@ -97,5 +363,19 @@ void Image_presenter::set_tool() {
         case Tool_bar::zoom:
             m_transform_tool.set_scale_mode();
             break;
+        case Tool_bar::window_level:
+        case Tool_bar::stack:
+            break;
+    }
+}
+
+Tool& Image_presenter::get_selected_tool() {
+    switch(m_tool_bar.get_selected_tool()) {
+        case Tool_bar::window_level:
+            return m_window_level_tool;
+        case Tool_bar::stack:
+            return m_stack_tool;
+        default:
+            return m_transform_tool;
     }
 }
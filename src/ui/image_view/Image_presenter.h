@@ -1,29 +1,81 @@
 #pragma once
+#include "models/Cine_player.h"
 #include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "models/Frame_decoder.h"
+#include "models/Frame_pacer.h"
+#include "models/Series_navigator.h"
+#include "models/Stack_tool.h"
 #include "models/Tool_bar.h"
 #include "models/Transform_tool.h"
+#include "models/Window_level_tool.h"
 #include "ui/IPresenter.h"
 #include "ui/image_view/IImage_view.h"
 
 #include <eventi/Scoped_callbacks.h>
 #include <QMouseEvent>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 class Image_presenter : public IPresenter
 {
 public:
-    Image_presenter(IImage_view&, Dataset_model&, Tool_bar&);
+    Image_presenter(IImage_view&, Dicom_files&, Dataset_model&, Frame_cache&, Frame_decoder&, Series_navigator&,
+        Tool_bar&);
 
 private:
     void setup_event_callbacks();
+    void on_dataset_changed(const Dataset_change&);
+    void on_file_saved();
     void update();
+    /** Repaint within a display frame, once for any number of calls. */
+    void schedule_update();
     void draw();
+    void draw_frame();
+    void log_frame_stats(Frame_pacer::Clock::time_point now);
     void on_mouse_move(QMouseEvent*);
     void on_mouse_press(QMouseEvent*);
     void set_tool();
+    Tool& get_selected_tool();
+    void set_frame(std::shared_ptr<const Rendered_frame>);
+    void apply_window();
+    void show_next_frame();
+    void show_previous_frame();
+    void toggle_cine();
+    void stop_cine();
+    void on_timer();
+    void decode_remaining_frames(Dicom_file&);
+    void step_slices(int steps);
 
     IImage_view& m_view;
+    Dicom_files& m_files;
     Dataset_model& m_dataset_model;
+    Frame_cache& m_frame_cache;
+    Frame_decoder& m_frame_decoder;
+    Series_navigator& m_series_navigator;
     Tool_bar& m_tool_bar;
     Transform_tool m_transform_tool;
+    Window_level_tool m_window_level_tool;
+    Stack_tool m_stack_tool;
+    /** The frame last passed to the view. */
+    std::shared_ptr<const Rendered_frame> m_frame;
+    unsigned long m_frame_index;
+    unsigned long m_frame_count;
+    /** Set when a new image is shown, so its own window is used. Otherwise
+     *  the window is kept between frames. */
+    bool m_reset_window;
+    /** Set while this view steps to another slice, which keeps the window. */
+    bool m_stepping_slices;
+    /** Set when the window changed since the last windowing of the frame. */
+    bool m_window_changed;
+    Frame_pacer m_frame_pacer;
+    Frame_pacer::Clock::time_point m_stats_start;
+    Cine_player m_cine_player;
+    /** Set once the remaining frames of the image are handed to m_frame_decoder. */
+    bool m_decode_started;
+    /** Monochrome frame after windowing, as passed to the view. Empty for tiled frames. */
+    std::vector<uint32_t> m_display_data;
     eventi::Scoped_callbacks m_scoped_callbacks;
 };
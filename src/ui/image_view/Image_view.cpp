@@ -1,34 +1,168 @@
 #include "ui/image_view/Image_view.h"
 
+#include "logging/Log.h"
+
 #include <QAction>
+#include <QElapsedTimer>
+#include <QGuiApplication>
 #include <QImage>
 #include <QMouseEvent>
 #include <QPainter>
+#include <QScreen>
+#include <QWheelEvent>
+#include <QWindow>
+#include <cmath>
+#include <string>
+#include <utility>
+
+const std::chrono::milliseconds slow_paint_time{16};
+const double default_refresh_rate{60.0};
+const int tile_pixmap_budget_kib{128 * 1024};
 
 Image_view::Image_view() {
     setFrameStyle(QFrame::Panel | QFrame::Raised);
     setMouseTracking(true);
     setContextMenuPolicy(Qt::ActionsContextMenu);
 
-    auto dataset_action = new QAction("Dataset view", this);
-    dataset_action->setShortcut({"2"});
-    dataset_action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
-    connect(dataset_action, &QAction::triggered, [this] {switch_to_dataset_view();});
-    addAction(dataset_action);
+    add_action("Dataset view", "2", [this] {switch_to_dataset_view();});
+    add_action("Next frame", "Right", [this] {next_frame_requested();});
+    add_action("Previous frame", "Left", [this] {previous_frame_requested();});
+    add_action("Play/pause", "Space", [this] {play_toggled();});
+    add_action("Next slice", "PgDown", [this] {slice_scrolled(1);});
+    add_action("Previous slice", "PgUp", [this] {slice_scrolled(-1);});
+
+    m_tile_pixmaps.setMaxCost(tile_pixmap_budget_kib);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, [this] {timer_elapsed();});
+    m_update_timer.setTimerType(Qt::PreciseTimer);
+    m_update_timer.setSingleShot(true);
+    connect(&m_update_timer, &QTimer::timeout, [this] {QWidget::update();});
+}
+
+void Image_view::add_action(const QString& text, const QString& shortcut, const std::function<void()>& triggered) {
+    auto action = new QAction(text, this);
+    action->setShortcut({shortcut});
+    action->setShortcutContext(Qt::WidgetWithChildrenShortcut);
+    connect(action, &QAction::triggered, triggered);
+    addAction(action);
 }
 
 void Image_view::update() {
     QWidget::update();
 }
 
-void Image_view::draw(const uint8_t* pixel_data, int width, int height, bool monochrome, const QTransform& transform) {
-    int bytes_per_line = monochrome ? 2 * width : 3 * width;
-    auto format = monochrome ? QImage::Format_Grayscale16 : QImage::Format_RGB888;
-    QImage image(pixel_data, width, height, bytes_per_line, format);
-    const QRect image_rect = image.rect();
+void Image_view::schedule_update(std::chrono::milliseconds delay) {
+    m_update_timer.start(delay);
+}
+
+double Image_view::get_refresh_rate() const {
+    const QWindow* window_handle = window()->windowHandle();
+    const QScreen* screen = window_handle ? window_handle->screen() : QGuiApplication::primaryScreen();
+    return screen ? screen->refreshRate() : default_refresh_rate;
+}
+
+static QImage::Format to_image_format(IImage_view::Pixel_format format) {
+    switch(format) {
+        case IImage_view::Pixel_format::rgb32:
+            return QImage::Format_RGB32;
+        case IImage_view::Pixel_format::rgb888:
+            return QImage::Format_RGB888;
+        case IImage_view::Pixel_format::gray16:
+            return QImage::Format_Grayscale16;
+    }
+    return QImage::Format_Invalid;
+}
+
+static int get_bytes_per_pixel(IImage_view::Pixel_format format) {
+    switch(format) {
+        case IImage_view::Pixel_format::rgb32:
+            return 4;
+        case IImage_view::Pixel_format::rgb888:
+            return 3;
+        case IImage_view::Pixel_format::gray16:
+            return 2;
+    }
+    return 0;
+}
+
+void Image_view::set_image(const uint8_t* pixel_data, int width, int height, Pixel_format format) {
+    QImage image(pixel_data, width, height, get_bytes_per_pixel(format) * width, to_image_format(format));
+    m_tile_pixmaps.clear();
+    m_mip_levels.clear();
+    m_pyramid.reset();
+    /* Pixmaps of the raster backend are stored as RGB32, so RGB32 images are
+    *  copied as they are and other formats are converted here, never in paint. */
+    m_pixmap = QPixmap::fromImage(image);
+}
+
+void Image_view::set_tiled_image(int width, int height, Image_pyramid::Tile_source source) {
+    m_pixmap = QPixmap();
+    m_mip_levels.clear();
+    m_tile_pixmaps.clear();
+    m_pyramid = std::make_unique<Image_pyramid>(QSize(width, height), std::move(source));
+}
+
+void Image_view::draw(const QTransform& transform) {
     QPainter painter(this);
     painter.setTransform(transform);
-    painter.drawPixmap(image_rect, QPixmap::fromImage(image), image_rect);
+
+    if(m_pyramid) {
+        draw_tiles(painter, transform);
+    }
+    else {
+        draw_pixmap(painter, transform);
+    }
+}
+
+void Image_view::draw_pixmap(QPainter& painter, const QTransform& transform) {
+    const int level = Image_pyramid::get_nearest_level(transform.m11(), m_pixmap.size());
+
+    if(level == 0) {
+        painter.drawPixmap(0, 0, m_pixmap);
+        return;
+    }
+    const double level_scale = std::ldexp(1.0, level);
+    painter.scale(level_scale, level_scale);
+    painter.setRenderHint(QPainter::SmoothPixmapTransform);
+    painter.drawPixmap(0, 0, get_mip_level(level));
+}
+
+const QPixmap& Image_view::get_mip_level(int level) {
+    const auto level_count = static_cast<size_t>(level);
+
+    if(m_mip_levels.size() < level_count) {
+        QImage image = m_mip_levels.empty() ? m_pixmap.toImage() : m_mip_levels.back().toImage();
+
+        while(m_mip_levels.size() < level_count) {
+            image = Image_pyramid::halve(image);
+            m_mip_levels.push_back(QPixmap::fromImage(image));
+        }
+    }
+    return m_mip_levels[level_count - 1];
+}
+
+void Image_view::draw_tiles(QPainter& painter, const QTransform& transform) {
+    const QRectF visible_rect = transform.inverted().mapRect(QRectF(rect()));
+    const int level = m_pyramid->get_level(transform.m11());
+    const double level_scale = std::ldexp(1.0, level);
+    painter.scale(level_scale, level_scale);
+
+    for(const QPoint& tile : m_pyramid->get_tiles(level, visible_rect)) {
+        painter.drawPixmap(tile * Image_pyramid::tile_size, get_tile_pixmap(level, tile));
+    }
+}
+
+const QPixmap& Image_view::get_tile_pixmap(int level, QPoint tile) {
+    const quint64 key = static_cast<quint64>(level) << 48 | static_cast<quint64>(tile.x()) << 24
+        | static_cast<quint64>(tile.y());
+    QPixmap* pixmap = m_tile_pixmaps.object(key);
+
+    if(!pixmap) {
+        pixmap = new QPixmap(QPixmap::fromImage(m_pyramid->get_tile(level, tile)));
+        const int cost_kib = pixmap->width() * pixmap->height() * 4 / 1024 + 1;
+        m_tile_pixmaps.insert(key, pixmap, cost_kib);
+    }
+    return *pixmap;
 }
 
 void Image_view::show_error(const std::string& text) {
@@ -36,9 +170,32 @@ void Image_view::show_error(const std::string& text) {
     painter.drawText(rect(), "Could not render image.\nReason: " + QString::fromStdString(text));
 }
 
+void Image_view::show_frame_number(unsigned long frame_number, unsigned long frame_count) {
+    QPainter painter(this);
+    painter.setPen(Qt::white);
+    const int margin = 8;
+    painter.drawText(rect().adjusted(margin, margin, -margin, -margin), Qt::AlignTop | Qt::AlignRight,
+        QString("%1 / %2").arg(frame_number).arg(frame_count));
+}
+
+void Image_view::start_timer(std::chrono::milliseconds interval) {
+    m_timer.start(interval);
+}
+
+void Image_view::stop_timer() {
+    m_timer.stop();
+}
+
 void Image_view::paintEvent(QPaintEvent* e) {
+    QElapsedTimer timer;
+    timer.start();
     draw_requested();
     QFrame::paintEvent(e);
+    const auto paint_time = std::chrono::milliseconds(timer.elapsed());
+
+    if(paint_time > slow_paint_time) {
+        Log::debug("Image paint took " + std::to_string(paint_time.count()) + " ms");
+    }
 }
 
 void Image_view::mouseMoveEvent(QMouseEvent* event) {
@@ -49,6 +206,20 @@ void Image_view::mousePressEvent(QMouseEvent* event) {
     mouse_pressed(event);
 }
 
+void Image_view::wheelEvent(QWheelEvent* event) {
+    // One notch is 120 units, touchpads send smaller deltas.
+    const int delta_per_slice = 120;
+    m_wheel_delta += event->angleDelta().y();
+    const int steps = m_wheel_delta / delta_per_slice;
+    m_wheel_delta -= steps * delta_per_slice;
+
+    // Scrolling down moves to the next slice.
+    if(steps != 0) {
+        slice_scrolled(-steps);
+    }
+    event->accept();
+}
+
 void Image_view::enterEvent(QEvent*) {
     setFocus(Qt::MouseFocusReason);
 }
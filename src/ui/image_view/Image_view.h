@@ -1,7 +1,16 @@
 #pragma once
+#include "models/Image_pyramid.h"
 #include "ui/image_view/IImage_view.h"
 
+#include <QCache>
 #include <QFrame>
+#include <QPainter>
+#include <QPixmap>
+#include <QTimer>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
 
 class Image_view : public QFrame, public IImage_view
 {
@@ -10,12 +19,39 @@ public:
     Image_view();
 
     void update() override;
-    void draw(const uint8_t* pixel_data, int width, int height, bool monochrome, const QTransform&) override;
+    void schedule_update(std::chrono::milliseconds delay) override;
+    double get_refresh_rate() const override;
+    void set_image(const uint8_t* pixel_data, int width, int height, Pixel_format) override;
+    void set_tiled_image(int width, int height, Image_pyramid::Tile_source) override;
+    void draw(const QTransform&) override;
     void show_error(const std::string&) override;
+    void show_frame_number(unsigned long frame_number, unsigned long frame_count) override;
+    void start_timer(std::chrono::milliseconds interval) override;
+    void stop_timer() override;
 
 private:
     void paintEvent(QPaintEvent*) override;
     void mouseMoveEvent(QMouseEvent*) override;
     void mousePressEvent(QMouseEvent*) override;
+    void wheelEvent(QWheelEvent*) override;
     void enterEvent(QEvent*) override;
+
+    void add_action(const QString& text, const QString& shortcut, const std::function<void()>& triggered);
+    void draw_pixmap(QPainter&, const QTransform&);
+    void draw_tiles(QPainter&, const QTransform&);
+    const QPixmap& get_tile_pixmap(int level, QPoint tile);
+    /** Returns m_pixmap halved level times, building the missing levels. */
+    const QPixmap& get_mip_level(int level);
+
+    QPixmap m_pixmap;
+    /** Downsampled copies of m_pixmap, starting at half size. */
+    std::vector<QPixmap> m_mip_levels;
+    /** Set instead of m_pixmap by set_tiled_image. */
+    std::unique_ptr<Image_pyramid> m_pyramid;
+    /** Uploaded tiles of m_pyramid, the cost is in KiB. */
+    QCache<quint64, QPixmap> m_tile_pixmaps;
+    QTimer m_timer;
+    QTimer m_update_timer;
+    /** Wheel rotation not yet counted as a slice. */
+    int m_wheel_delta{0};
 };
@@ -33,6 +33,8 @@ public:
     eventi::Event<> reset_layout_clicked;
     eventi::Event<> pan_tool_selected;
     eventi::Event<> zoom_tool_selected;
+    eventi::Event<> window_level_tool_selected;
+    eventi::Event<> stack_tool_selected;
 
     virtual void set_startup_view() = 0;
     virtual void set_editor_view() = 0;
@@ -41,6 +43,8 @@ public:
     virtual void set_window_title(const std::string&) = 0;
 
     virtual void show_error(const std::string& title, const std::string& text) = 0;
+    /** Show a message in the status bar for a while. */
+    virtual void show_status(const std::string&) = 0;
     virtual fs::path show_save_file_dialog() = 0;
     virtual bool show_discard_dialog() = 0;
     virtual void show_about_dialog() = 0;
@@ -13,13 +13,21 @@
 #include "ui/progressbar/Progress_presenter.h"
 
 #include <QCoreApplication>
+#include <algorithm>
 #include <memory>
+#include <string>
+
+const size_t max_listed_save_errors{10};
 
 Main_presenter::Main_presenter(IMain_view& view)
     : m_view(view),
       m_dataset_model(m_files),
+      m_frame_cache(m_files, m_dataset_model),
+      m_frame_decoder(m_frame_cache),
+      m_series_navigator(m_files, m_dataset_model, m_frame_cache),
       m_file_tree_model(m_files),
-      m_split_presenter(m_view.get_split_view(), m_dataset_model, m_tool_bar),
+      m_split_presenter(m_view.get_split_view(), m_files, m_dataset_model, m_frame_cache, m_frame_decoder,
+          m_series_navigator, m_tool_bar),
       m_file_tree_presenter(m_view.get_file_tree_view(), m_file_tree_model) {
     set_startup_view();
     m_split_presenter.set_default_layout();
@@ -41,9 +49,11 @@ void Main_presenter::setup_event_callbacks() {
     m_view.reset_layout_clicked.add_callback([this] {m_split_presenter.set_default_layout();});
     m_view.pan_tool_selected.add_callback([this] {m_tool_bar.set_selected_tool(Tool_bar::pan);});
     m_view.zoom_tool_selected.add_callback([this] {m_tool_bar.set_selected_tool(Tool_bar::zoom);});
+    m_view.window_level_tool_selected.add_callback([this] {m_tool_bar.set_selected_tool(Tool_bar::window_level);});
+    m_view.stack_tool_selected.add_callback([this] {m_tool_bar.set_selected_tool(Tool_bar::stack);});
     m_files.file_saved.add_callback([this] {update_window_title();});
-    m_file_tree_presenter.file_activated.add_callback([this] (Dicom_file* file) {m_files.set_current_file(file);});
-    m_dataset_model.dataset_changed.add_callback([this] {on_dataset_changed();});
+    m_file_tree_presenter.file_activated.add_callback([this] (Dicom_file* file) {set_current_file(file);});
+    m_dataset_model.dataset_changed.add_callback([this] (const Dataset_change&) {on_dataset_changed();});
 }
 
 void Main_presenter::on_dataset_changed() {
@@ -72,15 +82,30 @@ void Main_presenter::set_editor_view() {
 }
 
 void Main_presenter::open_files() {
-    std::unique_ptr<IOpen_files_view> view = m_view.create_open_files_view();
-    Open_files_presenter presenter(*view, m_files);
-    presenter.show_dialog();
+    if(is_opening()) {
+        m_view.show_error("Error", "Files are already being opened.");
+        return;
+    }
+    m_open_files_presenter.reset();
+    m_open_files_view = m_view.create_open_files_view();
+    m_open_files_presenter = std::make_unique<Open_files_presenter>(*m_open_files_view, m_files);
+    m_open_files_presenter->show_dialog();
 }
 
 void Main_presenter::open_folder() {
-    std::unique_ptr<IOpen_folder_view> view = m_view.create_open_folder_view();
-    Open_folder_presenter presenter(*view, m_files);
-    presenter.show_dialog();
+    if(is_opening()) {
+        m_view.show_error("Error", "Files are already being opened.");
+        return;
+    }
+    m_open_folder_presenter.reset();
+    m_open_folder_view = m_view.create_open_folder_view();
+    m_open_folder_presenter = std::make_unique<Open_folder_presenter>(*m_open_folder_view, m_files);
+    m_open_folder_presenter->show_dialog();
+}
+
+bool Main_presenter::is_opening() const {
+    return (m_open_files_presenter && m_open_files_presenter->is_opening())
+        || (m_open_folder_presenter && m_open_folder_presenter->is_opening());
 }
 
 void Main_presenter::new_file() {
@@ -89,6 +114,16 @@ void Main_presenter::new_file() {
     presenter.show_dialog();
 }
 
+void Main_presenter::set_current_file(Dicom_file* file) {
+    try {
+        m_files.set_current_file(file);
+    }
+    catch(const std::exception& e) {
+        m_view.show_error("Error", "Failed to load file: " + file->get_path().string() +
+            "\nReason: " + std::string(e.what()));
+    }
+}
+
 void Main_presenter::save_file() {
     Dicom_file* file = m_files.get_current_file();
     save_file_as(file->get_path());
@@ -113,17 +148,40 @@ void Main_presenter::save_file_as(const fs::path& path) {
 }
 
 void Main_presenter::save_all_files() {
+    // The files are saved in another thread, which must not see files being added.
+    if(is_opening()) {
+        m_view.show_error("Error", "Files can't be saved while files are being opened.");
+        return;
+    }
     std::unique_ptr<IProgress_view> progress_view = m_view.create_progress_view();
     Progress_presenter progress_presenter(*progress_view, "Saving all files");
+    Save_result result;
     auto thread_func = [&] {
-        bool ok = m_files.save_all_files(progress_presenter);
-
-        if(!ok) {
-            m_view.show_error("Error", "At least one file failed to save.");
-        }
+        result = m_files.save_all_files(progress_presenter);
         progress_presenter.close();
     };
     progress_presenter.execute(thread_func);
+
+    std::string status = "Saved " + std::to_string(result.saved_count) + " files, skipped " +
+        std::to_string(result.skipped_count) + " files without changes";
+
+    if(!result.ok()) {
+        status += ", " + std::to_string(result.errors.size()) + " files failed to save";
+    }
+    m_view.show_status(status + ".");
+
+    if(!result.ok()) {
+        std::string text = "At least one file failed to save.";
+
+        for(size_t i = 0; i < std::min(result.errors.size(), max_listed_save_errors); ++i) {
+            text += "\n\n" + result.errors[i];
+        }
+        if(result.errors.size() > max_listed_save_errors) {
+            text += "\n\n" + std::to_string(result.errors.size() - max_listed_save_errors) +
+                " more errors, see the log for details.";
+        }
+        m_view.show_error("Error", text);
+    }
 }
 
 void Main_presenter::clear_all_files() {
@@ -2,11 +2,17 @@
 #include "models/Dataset_model.h"
 #include "models/Dicom_files.h"
 #include "models/File_tree_model.h"
+#include "models/Frame_cache.h"
+#include "models/Frame_decoder.h"
+#include "models/Series_navigator.h"
 #include "models/Tool_bar.h"
 #include "ui/file_tree_view/File_tree_presenter.h"
 #include "ui/main_view/IMain_view.h"
+#include "ui/open_files_dialog/Open_files_presenter.h"
+#include "ui/open_folder_dialog/Open_folder_presenter.h"
 #include "ui/split_view/Split_presenter.h"
 #include <filesystem>
+#include <memory>
 
 namespace fs = std::filesystem;
 
@@ -23,10 +29,13 @@ private:
     void set_startup_view();
     void set_editor_view();
     void update_window_title();
+    /** Files are opened in the background. Only one open runs at a time. */
+    bool is_opening() const;
 
     void new_file();
     void open_files();
     void open_folder();
+    void set_current_file(Dicom_file*);
     void save_file();
     void save_file_as();
     void save_file_as(const fs::path&);
@@ -41,7 +50,14 @@ private:
     Dicom_files m_files;
     Tool_bar m_tool_bar;
     Dataset_model m_dataset_model;
+    Frame_cache m_frame_cache;
+    Frame_decoder m_frame_decoder;
+    Series_navigator m_series_navigator;
     File_tree_model m_file_tree_model;
     Split_presenter m_split_presenter;
     File_tree_presenter m_file_tree_presenter;
+    std::unique_ptr<IOpen_files_view> m_open_files_view;
+    std::unique_ptr<Open_files_presenter> m_open_files_presenter;
+    std::unique_ptr<IOpen_folder_view> m_open_folder_view;
+    std::unique_ptr<Open_folder_presenter> m_open_folder_presenter;
 };
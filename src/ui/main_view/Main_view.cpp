@@ -13,8 +13,11 @@
 #include <QMenuBar>
 #include <QMessageBox>
 #include <QStackedWidget>
+#include <QStatusBar>
 #include <QToolBar>
 
+const int status_timeout_ms{10000};
+
 Main_view::Main_view()
     : m_startup_view(new Startup_view()),
       m_split_view(new Split_view()),
@@ -64,6 +67,12 @@ void Main_view::show_error(const std::string& title, const std::string& text) {
     });
 }
 
+void Main_view::show_status(const std::string& text) {
+    QMetaObject::invokeMethod(this, [this, text] {
+        statusBar()->showMessage(QString::fromStdString(text), status_timeout_ms);
+    });
+}
+
 fs::path Main_view::show_save_file_dialog() {
     QString file_path = QFileDialog::getSaveFileName(this, "Save file as");
     return file_path.toStdString();
@@ -155,9 +164,17 @@ QToolBar* Main_view::create_editor_tool_bar() {
     QAction* zoom_action = tool_bar->addAction(QIcon(":/zoom.svg"), "Zoom", [this] {zoom_tool_selected();});
     zoom_action->setCheckable(true);
 
-    auto transform_group = new QActionGroup(tool_bar);
-    transform_group->addAction(pan_action);
-    transform_group->addAction(zoom_action);
+    QAction* window_level_action = tool_bar->addAction("Window/level", [this] {window_level_tool_selected();});
+    window_level_action->setCheckable(true);
+
+    QAction* stack_action = tool_bar->addAction("Stack", [this] {stack_tool_selected();});
+    stack_action->setCheckable(true);
+
+    auto tool_group = new QActionGroup(tool_bar);
+    tool_group->addAction(pan_action);
+    tool_group->addAction(zoom_action);
+    tool_group->addAction(window_level_action);
+    tool_group->addAction(stack_action);
 
     return tool_bar;
 }
@@ -22,6 +22,7 @@ public:
     void set_window_title(const std::string&) override;
 
     void show_error(const std::string& title, const std::string& text) override;
+    void show_status(const std::string&) override;
     fs::path show_save_file_dialog() override;
     bool show_discard_dialog() override;
     void show_about_dialog() override;
@@ -1,11 +1,12 @@
 #include "ui/open_files_dialog/Open_files_presenter.h"
 
 #include "models/Dicom_files.h"
+#include "models/File_loader.h"
 #include "ui/open_files_dialog/IOpen_files_view.h"
 #include "ui/progressbar/Progress_presenter.h"
 
-#include <eventi/Scoped_defer.h>
 #include <filesystem>
+#include <functional>
 #include <memory>
 #include <string>
 #include <vector>
@@ -22,28 +23,24 @@ void Open_files_presenter::show_dialog() {
     if (file_paths.empty()) {
         return;
     }
-    std::vector<std::string> file_errors;
-    eventi::Scoped_defer defer(m_dicom_files.current_file_set);
-    std::unique_ptr<IProgress_view> progress_view = m_view.create_progress_view();
-    Progress_presenter progress_presenter(*progress_view, "Opening files");
-    auto thread_func = [&] {
-        progress_presenter.set_max_progress(static_cast<int>(file_paths.size()));
-        for(const fs::path& file_path : file_paths) {
-            if(progress_presenter.cancelled()) {
-                break;
-            }
-            try {
-                m_dicom_files.open_file(file_path);
-            }
-            catch(const std::exception& e) {
-                file_errors.push_back("Failed to open file: " + file_path.string() +
-                    "\nReason: " + std::string(e.what()));
-            }
-            progress_presenter.increment_progress();
-        }
-        progress_presenter.close();
+    m_progress_view = m_view.create_progress_view();
+    m_progress_presenter = std::make_unique<Progress_presenter>(*m_progress_view, "Opening files");
+    m_loader = std::make_unique<File_loader>(m_dicom_files, *m_progress_presenter);
+    m_loader->set_commit_runner([this] (const std::function<void()>& commit) {
+        m_progress_presenter->run_in_view_thread(commit);
+    });
+    auto thread_func = [this, file_paths] {
+        m_loader->load_files(file_paths);
     };
-    progress_presenter.execute(thread_func);
+    m_progress_presenter->start(thread_func, [this] {on_files_opened();});
+}
+
+void Open_files_presenter::on_files_opened() {
+    const std::vector<std::string> file_errors = m_loader->get_errors();
+
+    m_progress_presenter.reset();
+    m_loader.reset();
+    m_progress_view.reset();
 
     if(!file_errors.empty()) {
         m_view.show_error(file_errors);
@@ -1,15 +1,28 @@
 #pragma once
 #include "models/Dicom_files.h"
+#include "models/File_loader.h"
 #include "ui/open_files_dialog/IOpen_files_view.h"
+#include "ui/progressbar/Progress_presenter.h"
+
+#include <memory>
 
 class Open_files_presenter
 {
 public:
     Open_files_presenter(IOpen_files_view&, Dicom_files&);
 
+    /** Starts opening the selected files and returns. The files are added
+     *  while the progress is shown, until they are opened or cancelled. */
     void show_dialog();
+    bool is_opening() const {return m_progress_presenter != nullptr;}
 
 private:
+    void on_files_opened();
+
     IOpen_files_view& m_view;
     Dicom_files& m_dicom_files;
+    std::unique_ptr<IProgress_view> m_progress_view;
+    std::unique_ptr<File_loader> m_loader;
+    // Destroyed first, it stops the loading thread.
+    std::unique_ptr<Progress_presenter> m_progress_presenter;
 };
@@ -1,6 +1,6 @@
 #include "ui/open_files_dialog/Open_files_view.h"
 
-#include "ui/progressbar/Progress_view.h"
+#include "ui/progressbar/Progress_bar_view.h"
 
 #include <QFileDialog>
 #include <QMessageBox>
@@ -31,5 +31,5 @@ void Open_files_view::show_error(const std::vector<std::string>& file_errors) {
 }
 
 std::unique_ptr<IProgress_view> Open_files_view::create_progress_view() {
-    return std::make_unique<Progress_view>(m_parent);
+    return std::make_unique<Progress_bar_view>(m_parent);
 }
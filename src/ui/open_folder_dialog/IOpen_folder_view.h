@@ -3,6 +3,7 @@
 
 #include <filesystem>
 #include <memory>
+#include <string>
 
 namespace fs = std::filesystem;
 
@@ -13,4 +14,7 @@ public:
 
     virtual fs::path show_dir_dialog() = 0;
     virtual std::unique_ptr<IProgress_view> create_progress_view() = 0;
+    /** Returns the directory where folder catalogs are kept. */
+    virtual fs::path get_cache_dir() = 0;
+    virtual void show_summary(const std::string&) = 0;
 };
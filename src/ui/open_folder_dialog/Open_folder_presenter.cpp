@@ -2,12 +2,14 @@
 
 #include "logging/Log.h"
 #include "models/Dicom_files.h"
+#include "models/File_loader.h"
+#include "models/Folder_catalog.h"
 #include "ui/open_folder_dialog/IOpen_folder_view.h"
 #include "ui/progressbar/Progress_presenter.h"
 
-#include <eventi/Scoped_defer.h>
 #include <exception>
 #include <filesystem>
+#include <functional>
 #include <string>
 
 namespace fs = std::filesystem;
@@ -22,26 +24,56 @@ void Open_folder_presenter::show_dialog() {
     if (dir.empty()) {
         return;
     }
-    eventi::Scoped_defer defer(m_dicom_files.current_file_set);
-    std::unique_ptr<IProgress_view> progress_view = m_view.create_progress_view();
-    Progress_presenter progress_presenter(*progress_view, "Opening folder");
-    auto thread_func = [&] {
-        const auto options = fs::directory_options::skip_permission_denied;
-        for(const fs::directory_entry& entry : fs::recursive_directory_iterator(dir, options)) {
-            if(progress_presenter.cancelled()) {
-                break;
-            }
-            try {
-                if(entry.is_regular_file()) {
-                    m_dicom_files.open_file(entry);
-                }
-            }
-            catch(const std::exception& e) {
-                Log::error("Failed to open file: " + entry.path().string() +
-                    "\nReason: " + std::string(e.what()));
-            }
+    m_catalog_path = Folder_catalog::get_catalog_path(m_view.get_cache_dir(), dir);
+    m_catalog = std::make_unique<Folder_catalog>(dir);
+    try {
+        m_catalog->load(m_catalog_path);
+    }
+    catch(const std::exception& e) {
+        Log::warning("Ignoring folder catalog " + m_catalog_path.string() + "\nReason: " + std::string(e.what()));
+    }
+    m_progress_view = m_view.create_progress_view();
+    m_progress_presenter = std::make_unique<Progress_presenter>(*m_progress_view, "Opening folder");
+    m_loader = std::make_unique<File_loader>(m_dicom_files, *m_progress_presenter);
+    m_loader->set_commit_runner([this] (const std::function<void()>& commit) {
+        m_progress_presenter->run_in_view_thread(commit);
+    });
+    m_loader->set_catalog(m_catalog.get());
+
+    auto thread_func = [this, dir] {
+        m_loader->load_folder(dir);
+        try {
+            m_catalog->save(m_catalog_path);
+        }
+        catch(const std::exception& e) {
+            Log::warning("Failed to save folder catalog " + m_catalog_path.string() + "\nReason: " + std::string(e.what()));
         }
-        progress_presenter.close();
     };
-    progress_presenter.execute(thread_func);
+    m_progress_presenter->start(thread_func, [this] {on_folder_opened();});
+}
+
+void Open_folder_presenter::on_folder_opened() {
+    const size_t opened_count = m_loader->get_opened_count();
+    const size_t skipped_count = m_loader->get_skipped_count();
+    const size_t failed_count = m_loader->get_errors().size();
+
+    for(const std::string& error : m_loader->get_errors()) {
+        Log::error(error);
+    }
+    m_progress_presenter.reset();
+    m_loader.reset();
+    m_progress_view.reset();
+    m_catalog.reset();
+
+    if(skipped_count > 0 || failed_count > 0) {
+        std::string summary = "Opened " + std::to_string(opened_count) + " files.";
+
+        if(skipped_count > 0) {
+            summary += "\nSkipped " + std::to_string(skipped_count) + " files that are not DICOM files.";
+        }
+        if(failed_count > 0) {
+            summary += "\n" + std::to_string(failed_count) + " files failed to open, see the log for details.";
+        }
+        m_view.show_summary(summary);
+    }
 }
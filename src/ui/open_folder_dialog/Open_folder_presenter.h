@@ -1,15 +1,34 @@
 #pragma once
 #include "models/Dicom_files.h"
+#include "models/File_loader.h"
+#include "models/Folder_catalog.h"
 #include "ui/open_folder_dialog/IOpen_folder_view.h"
+#include "ui/progressbar/Progress_presenter.h"
+
+#include <filesystem>
+#include <memory>
+
+namespace fs = std::filesystem;
 
 class Open_folder_presenter
 {
 public:
     Open_folder_presenter(IOpen_folder_view&, Dicom_files&);
 
+    /** Starts opening the selected folder and returns. The files are added
+     *  while the progress is shown, until they are opened or cancelled. */
     void show_dialog();
+    bool is_opening() const {return m_progress_presenter != nullptr;}
 
 private:
+    void on_folder_opened();
+
     IOpen_folder_view& m_view;
     Dicom_files& m_dicom_files;
+    fs::path m_catalog_path;
+    std::unique_ptr<Folder_catalog> m_catalog;
+    std::unique_ptr<IProgress_view> m_progress_view;
+    std::unique_ptr<File_loader> m_loader;
+    // Destroyed first, it stops the loading thread.
+    std::unique_ptr<Progress_presenter> m_progress_presenter;
 };
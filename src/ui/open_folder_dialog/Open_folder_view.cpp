@@ -1,8 +1,10 @@
 #include "ui/open_folder_dialog/Open_folder_view.h"
 
-#include "ui/progressbar/Progress_view.h"
+#include "ui/progressbar/Progress_bar_view.h"
 
 #include <QFileDialog>
+#include <QMessageBox>
+#include <QStandardPaths>
 
 Open_folder_view::Open_folder_view(QWidget* parent)
     : m_parent(parent) {}
@@ -12,5 +14,14 @@ fs::path Open_folder_view::show_dir_dialog() {
 }
 
 std::unique_ptr<IProgress_view> Open_folder_view::create_progress_view() {
-    return std::make_unique<Progress_view>(m_parent);
+    return std::make_unique<Progress_bar_view>(m_parent);
+}
+
+fs::path Open_folder_view::get_cache_dir() {
+    const QString cache_dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    return fs::path(cache_dir.toStdString()) / "catalogs";
+}
+
+void Open_folder_view::show_summary(const std::string& summary) {
+    QMessageBox::information(m_parent, "Open folder", QString::fromStdString(summary));
 }
@@ -10,6 +10,8 @@ public:
 
     fs::path show_dir_dialog() override;
     std::unique_ptr<IProgress_view> create_progress_view() override;
+    fs::path get_cache_dir() override;
+    void show_summary(const std::string&) override;
 
 private:
     QWidget* m_parent;
@@ -1,5 +1,6 @@
 #pragma once
 #include <eventi/Event.h>
+#include <functional>
 #include <string>
 
 class IProgress_view
@@ -12,7 +13,10 @@ public:
     virtual void set_max(int) = 0;
     virtual void set_value(int) = 0;
     virtual void set_text(const std::string&) = 0;
+    /** Queue func to run on the thread that shows the view. Returns without waiting for it. */
+    virtual void post_to_view_thread(const std::function<void()>& func) = 0;
 
+    /** A modal view returns when it is closed, others return right away. */
     virtual void show() = 0;
     virtual void close() = 0;
 };
@@ -0,0 +1,51 @@
+#include "ui/progressbar/Progress_bar_view.h"
+
+#include <QHBoxLayout>
+#include <QMainWindow>
+#include <QMetaObject>
+#include <QStatusBar>
+#include <QToolButton>
+
+Progress_bar_view::Progress_bar_view(QWidget* parent)
+    : QWidget(parent),
+      m_progress_bar(new QProgressBar()),
+      m_text(new QLabel()) {
+    auto layout = new QHBoxLayout(this);
+    layout->setContentsMargins(0, 0, 0, 0);
+    layout->addWidget(m_text);
+    layout->addWidget(m_progress_bar);
+
+    auto cancel_button = new QToolButton();
+    cancel_button->setText("Cancel");
+    connect(cancel_button, &QToolButton::clicked, [this] {cancel_requested();});
+    layout->addWidget(cancel_button);
+
+    if(auto main_window = qobject_cast<QMainWindow*>(parent->window())) {
+        main_window->statusBar()->addPermanentWidget(this);
+    }
+    QWidget::hide();
+}
+
+void Progress_bar_view::set_max(int max) {
+    QMetaObject::invokeMethod(this, [this, max] {m_progress_bar->setMaximum(max);});
+}
+
+void Progress_bar_view::set_value(int value) {
+    QMetaObject::invokeMethod(this, [this, value] {m_progress_bar->setValue(value);});
+}
+
+void Progress_bar_view::set_text(const std::string& text) {
+    QMetaObject::invokeMethod(this, [this, text] {m_text->setText(QString::fromStdString(text));});
+}
+
+void Progress_bar_view::post_to_view_thread(const std::function<void()>& func) {
+    QMetaObject::invokeMethod(this, func, Qt::QueuedConnection);
+}
+
+void Progress_bar_view::show() {
+    QWidget::show();
+}
+
+void Progress_bar_view::close() {
+    QMetaObject::invokeMethod(this, [this] {QWidget::hide();});
+}
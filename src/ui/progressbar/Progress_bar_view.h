@@ -0,0 +1,27 @@
+#pragma once
+#include "ui/progressbar/IProgress_view.h"
+
+#include <QLabel>
+#include <QProgressBar>
+#include <QWidget>
+
+/** Progress shown in the status bar of the main window, which can still be
+ *  used while the work runs. */
+class Progress_bar_view : public QWidget, public IProgress_view
+{
+    Q_OBJECT
+public:
+    Progress_bar_view(QWidget*);
+
+    void set_max(int) override;
+    void set_value(int) override;
+    void set_text(const std::string&) override;
+    void post_to_view_thread(const std::function<void()>&) override;
+
+    void show() override;
+    void close() override;
+
+private:
+    QProgressBar* m_progress_bar;
+    QLabel* m_text;
+};
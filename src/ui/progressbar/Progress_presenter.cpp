@@ -1,17 +1,29 @@
 #include "ui/progressbar/Progress_presenter.h"
 
-#include <thread>
-
 Progress_presenter::Progress_presenter(IProgress_view& view, const std::string& text)
     : m_view(view),
       m_progress(0),
-      m_cancelled(false) {
+      m_cancelled(false),
+      m_state(std::make_shared<Shared_state>()) {
     setup_event_callbacks();
     set_max_progress(0);
     m_view.set_value(m_progress);
     m_view.set_text(text);
 }
 
+Progress_presenter::~Progress_presenter() {
+    m_cancelled = true;
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+        m_state->closed = true;
+    }
+    m_state->call_done.notify_all();
+
+    if(m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
 void Progress_presenter::setup_event_callbacks() {
     m_view.cancel_requested.add_callback([this] {m_cancelled = true;});
 }
@@ -34,6 +46,64 @@ void Progress_presenter::execute(const std::function<void()>& thread_func) {
     thread.join();
 }
 
+void Progress_presenter::start(const std::function<void()>& thread_func, const std::function<void()>& finished) {
+    m_thread = std::thread([this, thread_func, finished] {
+        thread_func();
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        // The destructor is waiting for the thread, the view may be gone.
+        if(m_state->closed) {
+            return;
+        }
+        m_view.post_to_view_thread([this, finished, state = m_state] {
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+
+                if(state->closed) {
+                    return;
+                }
+            }
+            m_thread.join();
+            m_view.close();
+            finished();
+        });
+    });
+    m_view.show();
+}
+
+bool Progress_presenter::is_running() const {
+    return m_thread.joinable();
+}
+
+void Progress_presenter::run_in_view_thread(const std::function<void()>& func) {
+    auto done = std::make_shared<bool>(false);
+    {
+        std::lock_guard<std::mutex> lock(m_state->mutex);
+
+        if(m_state->closed) {
+            return;
+        }
+    }
+    m_view.post_to_view_thread([&func, done, state = m_state] {
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+
+            // The caller has stopped waiting, so func may be gone.
+            if(state->closed) {
+                return;
+            }
+        }
+        func();
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            *done = true;
+        }
+        state->call_done.notify_all();
+    });
+    std::unique_lock<std::mutex> lock(m_state->mutex);
+    m_state->call_done.wait(lock, [this, &done] {return *done || m_state->closed;});
+}
+
 void Progress_presenter::close() {
     m_view.close();
 }
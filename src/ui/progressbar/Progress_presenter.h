@@ -2,13 +2,21 @@
 #include "common/Progress_token.h"
 #include "ui/progressbar/IProgress_view.h"
 
+#include <atomic>
+#include <condition_variable>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 class Progress_presenter final : public Progress_token
 {
 public:
     Progress_presenter(IProgress_view&, const std::string& text = "");
+    /** Cancels a thread started with start() and waits for it. Functions it
+     *  queued for the view thread are not run. */
+    ~Progress_presenter();
 
     /** Set maximum value. 0 gives a busy indicator. */
     void set_max_progress(int) override;
@@ -17,12 +25,31 @@ public:
 
     /** Start thread_func in new thread, show progress view and wait for thread. */
     void execute(const std::function<void()>& thread_func);
+    /** Start thread_func in new thread, show progress view and return. When
+     *  thread_func has returned, the view is closed and finished is run on
+     *  the view thread. finished may destroy the presenter. */
+    void start(const std::function<void()>& thread_func, const std::function<void()>& finished);
+    bool is_running() const;
+    /** Run func on the view thread and wait for it to finish. Must not be
+     *  called from the view thread. */
+    void run_in_view_thread(const std::function<void()>& func);
     void close();
 
 private:
+    /** Shared with functions queued for the view thread, which may run after
+     *  the presenter is destroyed. */
+    struct Shared_state
+    {
+        std::mutex mutex;
+        std::condition_variable call_done;
+        bool closed = false;
+    };
+
     void setup_event_callbacks();
 
     IProgress_view& m_view;
     int m_progress;
-    bool m_cancelled;
+    std::atomic<bool> m_cancelled;
+    std::shared_ptr<Shared_state> m_state;
+    std::thread m_thread;
 };
@@ -29,6 +29,10 @@ void Progress_view::set_text(const std::string& text) {
     QMetaObject::invokeMethod(this, [this, text] {m_text->setText(QString::fromStdString(text));});
 }
 
+void Progress_view::post_to_view_thread(const std::function<void()>& func) {
+    QMetaObject::invokeMethod(this, func, Qt::QueuedConnection);
+}
+
 void Progress_view::show() {
     exec();
 }
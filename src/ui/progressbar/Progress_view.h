@@ -14,6 +14,7 @@ public:
     void set_max(int) override;
     void set_value(int) override;
     void set_text(const std::string&) override;
+    void post_to_view_thread(const std::function<void()>&) override;
 
     void show() override;
     void close() override;
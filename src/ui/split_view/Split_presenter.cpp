@@ -7,9 +7,14 @@
 
 #include <cassert>
 
-Split_presenter::Split_presenter(ISplit_view& view, Dataset_model& dataset_model, Tool_bar& tool_bar)
+Split_presenter::Split_presenter(ISplit_view& view, Dicom_files& files, Dataset_model& dataset_model,
+    Frame_cache& frame_cache, Frame_decoder& frame_decoder, Series_navigator& series_navigator, Tool_bar& tool_bar)
     : m_view(view),
+      m_files(files),
       m_dataset_model(dataset_model),
+      m_frame_cache(frame_cache),
+      m_frame_decoder(frame_decoder),
+      m_series_navigator(series_navigator),
       m_tool_bar(tool_bar) {}
 
 void Split_presenter::set_view_count(const size_t count) {
@@ -71,7 +76,8 @@ void Split_presenter::replace_view(IPresenter& target, Vp_pair vp) {
 
 Vp_pair Split_presenter::make_image_view() {
     std::unique_ptr<IImage_view> view = m_view.make_image_view();
-    auto presenter = std::make_unique<Image_presenter>(*view, m_dataset_model, m_tool_bar);
+    auto presenter = std::make_unique<Image_presenter>(*view, m_files, m_dataset_model, m_frame_cache,
+        m_frame_decoder, m_series_navigator, m_tool_bar);
     setup_event_callbacks(*view, *presenter);
     return {std::move(view), std::move(presenter)};
 }
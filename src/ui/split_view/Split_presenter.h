@@ -1,5 +1,9 @@
 #pragma once
 #include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "models/Frame_decoder.h"
+#include "models/Series_navigator.h"
 #include "models/Tool_bar.h"
 #include "ui/IPresenter.h"
 #include "ui/split_view/ISplit_view.h"
@@ -16,7 +20,8 @@ struct Vp_pair
 class Split_presenter
 {
 public:
-    Split_presenter(ISplit_view&, Dataset_model&, Tool_bar&);
+    Split_presenter(ISplit_view&, Dicom_files&, Dataset_model&, Frame_cache&, Frame_decoder&, Series_navigator&,
+        Tool_bar&);
 
     void set_view_count(size_t);
     void set_default_layout();
@@ -33,7 +38,11 @@ private:
     std::vector<Vp_pair> make_default_layout();
 
     ISplit_view& m_view;
+    Dicom_files& m_files;
     Dataset_model& m_dataset_model;
+    Frame_cache& m_frame_cache;
+    Frame_decoder& m_frame_decoder;
+    Series_navigator& m_series_navigator;
     Tool_bar& m_tool_bar;
     std::vector<std::unique_ptr<IPresenter>> m_presenters;
 };
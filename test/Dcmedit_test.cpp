@@ -7,12 +7,14 @@
 #include "mocks/Open_files_view_mock.h"
 #include "mocks/Progress_view_mock.h"
 #include "mocks/Split_view_mock.h"
+#include "mocks/View_thread_stub.h"
 #include "test_constants.h"
 
 #include <catch2/catch.hpp>
 #include <catch2/trompeloeil.hpp>
 
 #include <memory>
+#include <string>
 #include <vector>
 
 using trompeloeil::_;
@@ -58,15 +60,22 @@ public:
     }
 
     void open_file(const fs::path& path, bool require_show_editor_view) {
-        auto create_progress_view_mock = [] {
+        View_thread_stub view_thread;
+        bool progress_closed = false;
+        auto create_progress_view_mock = [&view_thread, &progress_closed] {
             auto view_mock = std::make_unique<Progress_view_mock>();
             view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, set_max(_))
                 .TIMES(2));
             view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, set_value(_))
                 .TIMES(2));
             view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, set_text("Opening files")));
+            // The batch of files and the end of the load.
+            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, post_to_view_thread(_))
+                .LR_SIDE_EFFECT(view_thread.post(_1))
+                .TIMES(2));
             view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, show()));
-            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, close()));
+            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, close())
+                .LR_SIDE_EFFECT(progress_closed = true));
             return view_mock;
         };
         auto create_open_files_view_mock = [path, create_progress_view_mock] {
@@ -92,10 +101,34 @@ public:
             .LR_SIDE_EFFECT(show_editor_view_count++);
 
         m_main_view_mock.open_files_clicked();
+        view_thread.run_until([&progress_closed] {return progress_closed;});
 
         CHECK(show_editor_view_count == (require_show_editor_view ? 1 : 0));
     }
 
+    void add_element(const fs::path& file_path, const std::string& tag_path, const std::string& value) {
+        auto dataset_view_mock = dynamic_cast<Dataset_view_mock*>(m_split_view_mock.m_views[0].get());
+        REQUIRE(dataset_view_mock != nullptr);
+        auto create_add_element_view_mock = [tag_path, value] {
+            auto view_mock = std::make_unique<Add_element_view_mock>();
+            Add_element_view_mock* view_mock_ptr = view_mock.get();
+            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, show_dialog())
+                .SIDE_EFFECT(view_mock_ptr->ok_clicked()));
+            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, tag_path())
+                .RETURN(tag_path));
+            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, value())
+                .RETURN(value));
+            view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, close_dialog()));
+            return view_mock;
+        };
+        REQUIRE_CALL(*dataset_view_mock, create_add_element_view())
+            .RETURN(create_add_element_view_mock());
+        REQUIRE_CALL(m_main_view_mock, set_window_modified(true));
+        REQUIRE_CALL(m_main_view_mock, set_window_title(file_path.string() + "[*] - dcmedit"));
+
+        dataset_view_mock->add_element_clicked(QModelIndex());
+    }
+
     std::vector<Image_view_mock*> get_image_view_mocks() {
         std::vector<Image_view_mock*> mocks;
         for(std::unique_ptr<IView>& view : m_split_view_mock.m_views) {
@@ -121,35 +154,26 @@ TEST_CASE_METHOD(Dcmedit_test_fixture, "Opening two files only shows the editor
     open_file(data_path / "new-file.dcm", false);
 }
 
-TEST_CASE_METHOD(Dcmedit_test_fixture, "Update() is called on image view when the dataset is edited") {
+TEST_CASE_METHOD(Dcmedit_test_fixture, "Update() is called on image view when an image attribute is edited") {
     fs::path file_path = data_path / "one-tag.dcm";
     open_file(file_path, true);
-    auto dataset_view_mock = dynamic_cast<Dataset_view_mock*>(m_split_view_mock.m_views[0].get());
-    REQUIRE(dataset_view_mock != nullptr);
-    auto create_add_element_view_mock = [] {
-        auto view_mock = std::make_unique<Add_element_view_mock>();
-        Add_element_view_mock* view_mock_ptr = view_mock.get();
-        view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, show_dialog())
-            .SIDE_EFFECT(view_mock_ptr->ok_clicked()));
-        view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, tag_path())
-            .RETURN("PatientID"));
-        view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, value())
-            .RETURN("foo"));
-        view_mock->expect.push_back(NAMED_REQUIRE_CALL(*view_mock, close_dialog()));
-        return view_mock;
-    };
-    REQUIRE_CALL(*dataset_view_mock, create_add_element_view())
-        .RETURN(create_add_element_view_mock());
 
     Named_expectations expectations;
     for(Image_view_mock* mock : get_image_view_mocks()) {
         expectations.push_back(NAMED_REQUIRE_CALL(*mock, update()));
     }
+    add_element(file_path, "Rows", "2");
+}
 
-    REQUIRE_CALL(m_main_view_mock, set_window_modified(true));
-    REQUIRE_CALL(m_main_view_mock, set_window_title(file_path.string() + "[*] - dcmedit"));
+TEST_CASE_METHOD(Dcmedit_test_fixture, "Update() is not called on image view when another attribute is edited") {
+    fs::path file_path = data_path / "one-tag.dcm";
+    open_file(file_path, true);
 
-    dataset_view_mock->add_element_clicked(QModelIndex());
+    Named_expectations expectations;
+    for(Image_view_mock* mock : get_image_view_mocks()) {
+        expectations.push_back(NAMED_FORBID_CALL(*mock, update()));
+    }
+    add_element(file_path, "PatientID", "foo");
 }
 
 TEST_CASE_METHOD(Dcmedit_test_fixture, "Clearing all files shows the startup view") {
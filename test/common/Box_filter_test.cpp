@@ -0,0 +1,42 @@
+#include "common/Box_filter.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <vector>
+
+static std::vector<uint32_t> halve(const std::vector<uint32_t>& pixels, int width, int height) {
+    const int output_width = (width + 1) / 2;
+    std::vector<uint32_t> output(static_cast<size_t>(output_width * ((height + 1) / 2)));
+    Box_filter::halve_rgb32(pixels.data(), width, height, static_cast<size_t>(width), output.data(),
+        static_cast<size_t>(output_width));
+    return output;
+}
+
+TEST_CASE("Testing Box_filter::halve_rgb32") {
+
+    SECTION("each channel of a 2x2 block is averaged and rounded") {
+        const std::vector<uint32_t> output = halve({0xff000000, 0xff0000ff, 0xff00ff00, 0xffff0001}, 2, 2);
+        CHECK(output == std::vector<uint32_t>{0xff404040});
+    }
+    SECTION("an odd last column and row are averaged with themselves") {
+        const std::vector<uint32_t> output = halve({
+            0xff000000, 0xff000000, 0xff0000f0,
+            0xff000000, 0xff000000, 0xff000010,
+            0xff080000, 0xff080000, 0xff000000}, 3, 3);
+        CHECK(output == std::vector<uint32_t>{0xff000000, 0xff000080, 0xff080000, 0xff000000});
+    }
+    SECTION("the result does not depend on SIMD") {
+        const int width = 37;
+        const int height = 5;
+        std::vector<uint32_t> pixels(static_cast<size_t>(width * height));
+        uint32_t value = 12345;
+        for(uint32_t& pixel : pixels) {
+            value = value * 1103515245 + 12345;
+            pixel = value;
+        }
+        std::vector<uint32_t> expected(static_cast<size_t>(19 * 3));
+        Box_filter::halve_rgb32_scalar(pixels.data(), width, height, width, expected.data(), 19);
+        CHECK(halve(pixels, width, height) == expected);
+    }
+}
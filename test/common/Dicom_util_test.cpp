@@ -1,5 +1,7 @@
 #include "common/Dicom_util.h"
 #include "common/Exceptions.h"
+#include "test_constants.h"
+#include "test_utils/Temp_dir.h"
 
 #include <catch2/catch.hpp>
 
@@ -8,6 +10,7 @@
 #include <dcmtk/dcmdata/dcdatset.h>
 #include <dcmtk/dcmdata/dcdeftag.h>
 #include <dcmtk/dcmdata/dcsequen.h>
+#include <fstream>
 #include <stdexcept>
 
 TEST_CASE("Testing Dicom_util::set_element with create_if_needed=true") {
@@ -131,3 +134,28 @@ TEST_CASE("Testing Dicom_util::get_index_nr") {
         CHECK(Dicom_util::get_index_nr(*item2) == 1);
 	}
 }
+
+TEST_CASE("Testing Dicom_util::looks_like_dicom") {
+
+    Temp_dir temp_dir;
+    const std::filesystem::path path = temp_dir.path() / "file";
+
+    SECTION("a file with DICM prefix is accepted") {
+        CHECK(Dicom_util::looks_like_dicom(data_path / "new-file.dcm"));
+	}
+    SECTION("a dataset without preamble is accepted") {
+        DcmDataset dataset;
+        REQUIRE(dataset.putAndInsertString(DCM_SOPClassUID, "1.2.3").good());
+        REQUIRE(dataset.saveFile(path.string().c_str(), EXS_LittleEndianImplicit).good());
+
+        CHECK(Dicom_util::looks_like_dicom(path));
+	}
+    SECTION("a text file is rejected") {
+        std::ofstream(path) << "This is not a DICOM file, but it is long enough to be checked.";
+
+        CHECK_FALSE(Dicom_util::looks_like_dicom(path));
+	}
+    SECTION("a missing file is rejected") {
+        CHECK_FALSE(Dicom_util::looks_like_dicom(temp_dir.path() / "missing"));
+	}
+}
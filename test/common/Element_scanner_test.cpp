@@ -0,0 +1,96 @@
+#include "common/Element_scanner.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <dcmtk/dcmdata/dcsequen.h>
+#include <stdexcept>
+
+static void save_test_file(const fs::path& path, E_TransferSyntax transfer_syntax) {
+    DcmFileFormat file;
+    DcmDataset& dataset = *file.getDataset();
+    REQUIRE(dataset.putAndInsertString(DCM_PatientName, "Doe^John").good());
+    REQUIRE(dataset.putAndInsertString(DCM_PatientID, "117").good());
+
+    auto sequence = new DcmSequenceOfItems(DCM_ReferencedImageSequence);
+    auto item = new DcmItem();
+    REQUIRE(item->putAndInsertString(DCM_ReferencedSOPInstanceUID, "1.2.3").good());
+    REQUIRE(sequence->append(item).good());
+    REQUIRE(dataset.insert(sequence).good());
+
+    REQUIRE(file.saveFile(path.string().c_str(), transfer_syntax, EET_UndefinedLength).good());
+}
+
+static void save_encapsulated_file(const fs::path& path) {
+    DcmFileFormat file;
+    auto sequence = new DcmPixelSequence(DCM_PixelSequenceTag);
+    REQUIRE(sequence->insert(new DcmPixelItem(DCM_PixelItemTag)).good());
+    const Uint8 fragment_data[6] = {1, 2, 3, 4, 5, 6};
+    auto fragment = new DcmPixelItem(DCM_PixelItemTag);
+    REQUIRE(fragment->putUint8Array(fragment_data, 6).good());
+    REQUIRE(sequence->insert(fragment).good());
+    auto pixel_data = new DcmPixelData(DCM_PixelData);
+    pixel_data->putOriginalRepresentation(EXS_RLELossless, nullptr, sequence);
+    REQUIRE(file.getDataset()->insert(pixel_data).good());
+
+    REQUIRE(file.saveFile(path.string().c_str(), EXS_RLELossless).good());
+}
+
+TEST_CASE("Testing Element_scanner::scan_file") {
+
+    Temp_dir temp_dir;
+    const fs::path path = temp_dir.path() / "file.dcm";
+
+    SECTION("elements of an explicit VR file are listed in order with contiguous ranges") {
+        save_test_file(path, EXS_LittleEndianExplicit);
+        const File_layout layout = Element_scanner::scan_file(path);
+
+        CHECK(layout.transfer_syntax == EXS_LittleEndianExplicit);
+        REQUIRE(!layout.meta_elements.empty());
+        REQUIRE(layout.dataset_elements.size() == 3);
+        CHECK(layout.dataset_elements[0].tag == DCM_ReferencedImageSequence);
+        CHECK(layout.dataset_elements[0].undefined_length);
+        CHECK(layout.dataset_elements[1].tag == DCM_PatientName);
+        CHECK(layout.dataset_elements[2].tag == DCM_PatientID);
+
+        const Element_location& last_meta = layout.meta_elements.back();
+        CHECK(layout.dataset_elements[0].offset == last_meta.offset + last_meta.size);
+        for(size_t i = 1; i < layout.dataset_elements.size(); ++i) {
+            const Element_location& previous = layout.dataset_elements[i - 1];
+            CHECK(layout.dataset_elements[i].offset == previous.offset + previous.size);
+        }
+        const Element_location& last = layout.dataset_elements.back();
+        CHECK(last.offset + last.size == layout.file_size);
+	}
+    SECTION("elements of an implicit VR file are listed") {
+        save_test_file(path, EXS_LittleEndianImplicit);
+        const File_layout layout = Element_scanner::scan_file(path);
+
+        CHECK(layout.transfer_syntax == EXS_LittleEndianImplicit);
+        CHECK(layout.dataset_elements.size() == 3);
+	}
+    SECTION("the items of encapsulated pixel data are listed") {
+        save_encapsulated_file(path);
+        const File_layout layout = Element_scanner::scan_file(path);
+
+        REQUIRE(layout.dataset_elements.size() == 1);
+        const Element_location& pixel_data = layout.dataset_elements[0];
+        CHECK(pixel_data.undefined_length);
+        REQUIRE(pixel_data.items.size() == 2);
+        CHECK(pixel_data.items[0].offset == pixel_data.offset + 12);
+        CHECK(pixel_data.items[0].size == 8);
+        CHECK(pixel_data.items[1].offset == pixel_data.items[0].offset + 8);
+        CHECK(pixel_data.items[1].size == 14);
+        // The sequence delimitation item follows the fragments.
+        CHECK(pixel_data.items[1].offset + pixel_data.items[1].size + 8 == pixel_data.offset + pixel_data.size);
+	}
+    SECTION("a big endian file causes an exception to be thrown") {
+        save_test_file(path, EXS_BigEndianExplicit);
+        CHECK_THROWS_AS(Element_scanner::scan_file(path), std::runtime_error);
+	}
+}
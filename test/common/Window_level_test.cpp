@@ -0,0 +1,84 @@
+#include "common/Window_level.h"
+
+#include <catch2/catch.hpp>
+
+#include <cstdint>
+#include <vector>
+
+static std::vector<uint8_t> apply(const std::vector<int32_t>& values, double center, double width, bool inverse) {
+    std::vector<uint8_t> output(values.size());
+    Window_level::apply(values.data(), values.size(), center, width, inverse, output.data());
+    return output;
+}
+
+TEST_CASE("Testing Window_level::apply") {
+
+    SECTION("values below and above the window are clamped") {
+        const std::vector<uint8_t> output = apply({-1000, 0, 255, 1000}, 128, 256, false);
+        CHECK(output == std::vector<uint8_t>{0, 0, 255, 255});
+    }
+    SECTION("inverse maps low values to bright pixels") {
+        const std::vector<uint8_t> output = apply({-1000, 0, 255, 1000}, 128, 256, true);
+        CHECK(output == std::vector<uint8_t>{255, 255, 0, 0});
+    }
+    SECTION("a window of width one is a threshold") {
+        const std::vector<uint8_t> output = apply({99, 100, 101}, 100, 1, false);
+        CHECK(output == std::vector<uint8_t>{0, 255, 255});
+    }
+    SECTION("the result does not depend on SIMD") {
+        std::vector<int32_t> values;
+        for(int32_t value = -40000; value < 40000; value += 7) {
+            values.push_back(value);
+        }
+        for(double width : {1.0, 2.0, 400.0, 65536.0}) {
+            std::vector<uint8_t> expected(values.size());
+            Window_level::apply_scalar(values.data(), values.size(), 40.0, width, false, expected.data());
+            CHECK(apply(values, 40.0, width, false) == expected);
+        }
+    }
+}
+
+TEST_CASE("Testing Window_level::apply_rgb32") {
+    std::vector<int32_t> values;
+    for(int32_t value = -300; value < 300; ++value) {
+        values.push_back(value);
+    }
+    const std::vector<uint8_t> gray = apply(values, 20.0, 300.0, true);
+    std::vector<uint32_t> pixels(values.size());
+    Window_level::apply_rgb32(values.data(), values.size(), 20.0, 300.0, true, pixels.data());
+
+    for(size_t i = 0; i < values.size(); ++i) {
+        CHECK(pixels[i] == (0xff000000 | gray[i] * uint32_t{0x010101}));
+    }
+}
+
+template<typename T>
+static void check_narrow_rgb32(size_t count) {
+    std::vector<T> values(count);
+    std::vector<int32_t> wide_values(count);
+    for(size_t i = 0; i < count; ++i) {
+        values[i] = static_cast<T>(i * 7);
+        wide_values[i] = values[i];
+    }
+    std::vector<uint32_t> expected(count);
+    Window_level::apply_rgb32(wide_values.data(), count, 20.0, 300.0, true, expected.data());
+    std::vector<uint32_t> pixels(count);
+    Window_level::apply_rgb32(values.data(), count, 20.0, 300.0, true, pixels.data());
+
+    CHECK(pixels == expected);
+}
+
+TEST_CASE("Testing Window_level::apply_rgb32 for values of up to 16 bits") {
+
+    SECTION("few values are windowed as 32-bit values") {
+        check_narrow_rgb32<uint16_t>(1000);
+        check_narrow_rgb32<int16_t>(1000);
+        check_narrow_rgb32<int8_t>(100);
+    }
+    SECTION("many values are windowed through a table with the same result") {
+        check_narrow_rgb32<uint16_t>(70000);
+        check_narrow_rgb32<int16_t>(70000);
+        check_narrow_rgb32<uint8_t>(1000);
+        check_narrow_rgb32<int8_t>(1000);
+    }
+}
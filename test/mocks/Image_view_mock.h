@@ -8,6 +8,13 @@ class Image_view_mock : public trompeloeil::mock_interface<IImage_view>
 {
 public:
     IMPLEMENT_MOCK0(update);
-    IMPLEMENT_MOCK5(draw);
+    IMPLEMENT_MOCK1(schedule_update);
+    IMPLEMENT_CONST_MOCK0(get_refresh_rate);
+    IMPLEMENT_MOCK4(set_image);
+    IMPLEMENT_MOCK3(set_tiled_image);
+    IMPLEMENT_MOCK1(draw);
     IMPLEMENT_MOCK1(show_error);
+    IMPLEMENT_MOCK2(show_frame_number);
+    IMPLEMENT_MOCK1(start_timer);
+    IMPLEMENT_MOCK0(stop_timer);
 };
@@ -12,6 +12,7 @@ public:
     IMPLEMENT_MOCK1(set_window_modified);
     IMPLEMENT_MOCK1(set_window_title);
     IMPLEMENT_MOCK2(show_error);
+    IMPLEMENT_MOCK1(show_status);
     IMPLEMENT_MOCK0(show_save_file_dialog);
     IMPLEMENT_MOCK0(show_discard_dialog);
     IMPLEMENT_MOCK0(show_about_dialog);
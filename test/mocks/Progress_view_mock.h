@@ -13,6 +13,7 @@ public:
     IMPLEMENT_MOCK1(set_max);
     IMPLEMENT_MOCK1(set_value);
     IMPLEMENT_MOCK1(set_text);
+    IMPLEMENT_MOCK1(post_to_view_thread);
     IMPLEMENT_MOCK0(show);
     IMPLEMENT_MOCK0(close);
 
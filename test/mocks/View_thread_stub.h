@@ -0,0 +1,37 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+/** Stands in for the event loop of the view thread. Posted functions run on
+ *  the thread that calls run_until(). */
+class View_thread_stub
+{
+public:
+    void post(const std::function<void()>& func) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_funcs.push_back(func);
+        }
+        m_func_posted.notify_one();
+    }
+
+    void run_until(const std::function<bool()>& done) {
+        while(!done()) {
+            std::function<void()> func;
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_func_posted.wait(lock, [this] {return !m_funcs.empty();});
+                func = std::move(m_funcs.front());
+                m_funcs.pop_front();
+            }
+            func();
+        }
+    }
+
+private:
+    std::mutex m_mutex;
+    std::condition_variable m_func_posted;
+    std::deque<std::function<void()>> m_funcs;
+};
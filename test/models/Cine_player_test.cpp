@@ -0,0 +1,86 @@
+#include "models/Cine_player.h"
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "test_utils/Image_file.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <dcmtk/dcmdata/dcdatset.h>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <chrono>
+#include <thread>
+
+const unsigned long test_frame_count{4};
+
+static Cine_player::Frame wait_for_frame(Cine_player& player) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+
+    while(std::chrono::steady_clock::now() < deadline) {
+        Cine_player::Frame frame = player.take_due_frame();
+
+        if(frame.frame != nullptr) {
+            return frame;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return {};
+}
+
+TEST_CASE("Cine player") {
+    Temp_dir temp_dir;
+    const fs::path path = temp_dir.path() / "cine.dcm";
+    Image_file_options image;
+    image.frame_count = test_frame_count;
+    save_image_file(path, image);
+    Dicom_files files;
+    Dataset_model dataset_model(files);
+    Frame_cache cache(files, dataset_model);
+    files.open_file(path);
+    Dicom_file& file = *files.get_current_file();
+    Cine_player player(cache);
+
+    SECTION("The frame count is rendered with each frame") {
+        CHECK(cache.get_frame(file, 0)->frame_count == test_frame_count);
+    }
+
+    SECTION("Played frames are decoded in the background and cached") {
+        player.play(file, 1, test_frame_count, 100.0);
+        CHECK(player.is_playing());
+        const Cine_player::Frame frame = wait_for_frame(player);
+        REQUIRE(frame.frame != nullptr);
+        CHECK(frame.frame->error.empty());
+        CHECK(frame.index < test_frame_count);
+        CHECK(frame.frame->width == 2);
+        CHECK(cache.find(file, frame.index) == frame.frame);
+
+        player.stop();
+        CHECK(!player.is_playing());
+    }
+
+    SECTION("A file with unsaved changes is played from its dataset") {
+        dataset_model.add_element(QModelIndex(), "PatientID", "117");
+        REQUIRE(file.has_unsaved_changes());
+        player.play(file, 0, test_frame_count, 100.0);
+        const Cine_player::Frame frame = wait_for_frame(player);
+        REQUIRE(frame.frame != nullptr);
+        CHECK(frame.frame->error.empty());
+    }
+}
+
+TEST_CASE("Cine frame rate") {
+    DcmDataset dataset;
+
+    SECTION("Cine Rate is used first") {
+        REQUIRE(dataset.putAndInsertString(DCM_CineRate, "15").good());
+        REQUIRE(dataset.putAndInsertString(DCM_FrameTime, "100").good());
+        CHECK(Cine_player::get_frame_rate(dataset) == Approx(15.0));
+    }
+    SECTION("Frame Time is in milliseconds") {
+        REQUIRE(dataset.putAndInsertString(DCM_FrameTime, "40").good());
+        CHECK(Cine_player::get_frame_rate(dataset) == Approx(25.0));
+    }
+    SECTION("A default rate is used without timing attributes") {
+        CHECK(Cine_player::get_frame_rate(dataset) > 0.0);
+    }
+}
@@ -1,4 +1,5 @@
 #include "common/Exceptions.h"
+#include "common/File_util.h"
 #include "models/Dicom_files.h"
 #include "mocks/Progress_token_stub.h"
 #include "test_constants.h"
@@ -7,10 +8,25 @@
 
 #include <catch2/catch.hpp>
 #include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcelem.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <dcmtk/dcmdata/dcpixel.h>
+#include <dcmtk/dcmdata/dcpixseq.h>
+#include <dcmtk/dcmdata/dcpxitem.h>
+#include <algorithm>
+#include <memory>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 namespace fs = std::filesystem;
 
+static bool has_temp_files(const fs::path& dir) {
+    return std::any_of(fs::directory_iterator(dir), fs::directory_iterator(), [] (const fs::directory_entry& entry) {
+        return File_util::is_temp_path(entry.path());
+    });
+}
+
 TEST_CASE("Open a file") {
     Dicom_files files;
 
@@ -30,6 +46,21 @@ TEST_CASE("Open a file") {
         CHECK(files.get_current_file() != nullptr);
 	}
 
+    SECTION("Open a file that is already open through another path. The file is replaced.") {
+        Temp_dir temp_dir;
+        fs::path original_path = temp_dir.path() / "original.dcm";
+        fs::path link_path = temp_dir.path() / "link.dcm";
+        fs::copy_file(data_path / "new-file.dcm", original_path);
+        fs::create_hard_link(original_path, link_path);
+        files.open_file(original_path);
+        files.open_file(temp_dir.path() / "." / "original.dcm");
+        files.open_file(link_path);
+
+        CHECK(files.get_files().size() == 1);
+        CHECK(files.find_file(original_path) == files.get_current_file());
+        CHECK(files.is_open(files.get_current_file()));
+	}
+
     SECTION("Open a file that is already open and has unsaved changes throws an exception") {
         files.open_file(data_path / "new-file.dcm");
         files.get_current_file()->set_unsaved_changes(true);
@@ -40,6 +71,47 @@ TEST_CASE("Open a file") {
 	}
 }
 
+TEST_CASE("Files are opened header-only and fully loaded when set as current") {
+    Dicom_files files;
+    files.open_file(data_path / "new-file.dcm");
+    Dicom_file* first = files.get_current_file();
+    CHECK(first->is_fully_loaded());
+
+    Load_options options;
+    options.header_only = true;
+    auto file = std::make_unique<Dicom_file>(data_path / "one-tag.dcm", options);
+    CHECK(!file->is_fully_loaded());
+
+    Dicom_file* second = files.add_file(std::move(file));
+    CHECK(files.get_current_file() == first);
+
+    files.set_current_file(second);
+    CHECK(second->is_fully_loaded());
+}
+
+TEST_CASE("Values longer than the max read length of the load options are left on disk") {
+    Temp_dir temp_dir;
+    const fs::path path = temp_dir.path() / "file.dcm";
+    DcmFileFormat file_format;
+    file_format.getDataset()->putAndInsertString(DCM_PatientComments, std::string(100, 'a').c_str());
+    file_format.getDataset()->putAndInsertString(DCM_ImageComments, std::string(300, 'b').c_str());
+    REQUIRE(file_format.saveFile(path.c_str(), EXS_LittleEndianExplicit).good());
+
+    Dicom_files files;
+    Load_options options = files.get_load_options();
+    options.max_read_length = 200;
+    files.set_load_options(options);
+    files.open_file(path);
+    DcmDataset& dataset = files.get_current_file()->get_dataset();
+    DcmElement* short_element = nullptr;
+    DcmElement* long_element = nullptr;
+    REQUIRE(dataset.findAndGetElement(DCM_PatientComments, short_element).good());
+    REQUIRE(dataset.findAndGetElement(DCM_ImageComments, long_element).good());
+
+    CHECK(short_element->valueLoaded());
+    CHECK(!long_element->valueLoaded());
+}
+
 TEST_CASE("Create a new file") {
     Dicom_files files;
     Temp_dir temp_dir;
@@ -143,9 +215,124 @@ TEST_CASE("Save all files. Event is triggered and all files are saved.") {
     files.get_current_file()->set_unsaved_changes(true);
     Check_event check_event(files.file_saved);
     Progress_token_stub progress_stub;
-    files.save_all_files(progress_stub);
+    Save_result result = files.save_all_files(progress_stub);
 
     CHECK(!files.has_unsaved_changes());
+    CHECK(result.ok());
+    CHECK(result.saved_count == 2);
+}
+
+TEST_CASE("Save all files in parallel. Each file is saved and errors are collected.") {
+    Dicom_files files;
+    Temp_dir temp_dir;
+    for(int i = 0; i < 8; ++i) {
+        files.create_new_file(temp_dir.path() / ("file" + std::to_string(i)));
+        files.get_current_file()->set_unsaved_changes(true);
+    }
+    fs::create_directory(temp_dir.path() / "removed");
+    files.create_new_file(temp_dir.path() / "removed" / "file");
+    files.get_current_file()->set_unsaved_changes(true);
+    fs::remove_all(temp_dir.path() / "removed");
+
+    Save_options options;
+    options.thread_count = 4;
+    options.max_concurrent_writes = 1;
+    options.max_concurrent_full_saves = 1;
+    options.durable = false;
+    files.set_save_options(options);
+    Progress_token_stub progress_stub;
+    Save_result result = files.save_all_files(progress_stub);
+
+    CHECK(result.saved_count == 8);
+    CHECK(result.errors.size() == 1);
+    CHECK_NOTHROW(Dicom_file(temp_dir.path() / "file0"));
+}
+
+TEST_CASE("Save files through temporary files. The originals are replaced when the files are written.") {
+    Dicom_files files;
+    Temp_dir temp_dir;
+    fs::path path = temp_dir.path() / "file";
+    files.create_new_file(path);
+    Dicom_file* file = files.get_current_file();
+    file->set_unsaved_changes(true);
+
+    SECTION("No temporary file is left after saving") {
+        files.save_current_file_as(path);
+        CHECK(!file->has_staged_file());
+        CHECK(!has_temp_files(temp_dir.path()));
+    }
+
+    SECTION("A failed write leaves the original file") {
+        const auto write_time = fs::last_write_time(path);
+
+        CHECK_THROWS(files.save_current_file_as(temp_dir.path() / "missing" / "file"));
+        CHECK(file->has_unsaved_changes());
+        CHECK(!file->has_staged_file());
+        CHECK(file->get_path() == path);
+        CHECK(fs::last_write_time(path) == write_time);
+        CHECK(!has_temp_files(temp_dir.path()));
+        CHECK_NOTHROW(Dicom_file(path));
+    }
+
+    SECTION("The saved file keeps the permissions of the original") {
+        const fs::perms permissions = fs::perms::owner_read | fs::perms::owner_write | fs::perms::group_read;
+        fs::permissions(path, permissions);
+        files.save_current_file_as(path);
+
+        CHECK((fs::status(path).permissions() & fs::perms::mask) == permissions);
+    }
+
+    SECTION("A file with several hard links is saved in place, so the links stay the same file") {
+        const fs::path link_path = temp_dir.path() / "link";
+        fs::create_hard_link(path, link_path);
+        const File_identity identity = File_util::get_identity(path);
+        Progress_token_stub progress_stub;
+        Save_result result = files.save_all_files(progress_stub);
+
+        CHECK(result.saved_count == 1);
+        CHECK(File_util::get_identity(path) == identity);
+        CHECK(fs::hard_link_count(link_path) == 2);
+        CHECK(!has_temp_files(temp_dir.path()));
+    }
+
+    SECTION("A file saved through a symbolic link replaces the file it points to") {
+        const fs::path link_path = temp_dir.path() / "symlink";
+        fs::create_symlink(path.filename(), link_path);
+        files.save_current_file_as(link_path);
+
+        CHECK(fs::is_symlink(link_path));
+        CHECK(fs::read_symlink(link_path) == path.filename());
+        CHECK(fs::is_regular_file(fs::symlink_status(path)));
+        CHECK(!has_temp_files(temp_dir.path()));
+        CHECK_NOTHROW(Dicom_file(path));
+    }
+
+    SECTION("Saving all files syncs the files before they replace the originals") {
+        Progress_token_stub progress_stub;
+        Save_result result = files.save_all_files(progress_stub);
+
+        CHECK(result.saved_count == 1);
+        CHECK(!file->has_staged_file());
+        CHECK(!has_temp_files(temp_dir.path()));
+        CHECK(files.find_file(path) == file);
+    }
+}
+
+TEST_CASE("Save all files. Files without unsaved changes are skipped.") {
+    Dicom_files files;
+    Temp_dir temp_dir;
+    fs::path path_1 = temp_dir.path() / "file1";
+    fs::path path_2 = temp_dir.path() / "file2";
+    files.create_new_file(path_1);
+    files.create_new_file(path_2);
+    files.get_current_file()->set_unsaved_changes(true);
+    const auto clean_write_time = fs::last_write_time(path_1);
+    Progress_token_stub progress_stub;
+    Save_result result = files.save_all_files(progress_stub);
+
+    CHECK(result.saved_count == 1);
+    CHECK(result.skipped_count == 1);
+    CHECK(fs::last_write_time(path_1) == clean_write_time);
 }
 
 TEST_CASE("Set current file. Event is triggered and current file is set.") {
@@ -159,3 +346,167 @@ TEST_CASE("Set current file. Event is triggered and current file is set.") {
     files.set_current_file(file);
     CHECK(files.get_current_file() == file);
 }
+
+TEST_CASE("A file added with index keys made beforehand replaces the open file") {
+    Dicom_files files;
+    files.open_file(data_path / "one-tag.dcm");
+    const Dicom_files::Index_keys keys = Dicom_files::make_index_keys(data_path / "one-tag.dcm");
+    Dicom_file* file = files.add_file(std::make_unique<Dicom_file>(data_path / "one-tag.dcm"), keys);
+
+    CHECK(files.get_files().size() == 1);
+    CHECK(files.find_file(data_path / "one-tag.dcm") == file);
+}
+
+TEST_CASE("A file that fails to load fully does not become the current file") {
+    Dicom_files files;
+    files.open_file(data_path / "one-tag.dcm");
+    Dicom_file* current_file = files.get_current_file();
+    Dicom_file* missing_file = files.add_file(std::make_unique<Dicom_file>(data_path / "missing.dcm", File_summary()));
+
+    CHECK_THROWS(files.set_current_file(missing_file));
+    CHECK(files.get_current_file() == current_file);
+    CHECK_FALSE(missing_file->is_fully_loaded());
+}
+
+TEST_CASE("Save a changed value by patching the file") {
+    Temp_dir temp_dir;
+    fs::path path = temp_dir.path() / "file";
+    {
+        DcmFileFormat file;
+        REQUIRE(file.getDataset()->putAndInsertString(DCM_PatientID, "AAAA").good());
+        REQUIRE(file.getDataset()->putAndInsertString(DCM_PatientName, "Doe^John").good());
+        REQUIRE(file.saveFile(path.string().c_str(), EXS_LittleEndianExplicit).good());
+    }
+    Dicom_file file(path);
+    DcmElement* element = nullptr;
+    REQUIRE(file.get_dataset().findAndGetElement(DCM_PatientID, element).good());
+
+    SECTION("A value with the same length is patched") {
+        REQUIRE(element->putString("BBBB").good());
+        file.mark_modified(DCM_PatientID);
+
+        CHECK(file.try_patch_file());
+        CHECK(!file.has_unsaved_changes());
+        Dicom_file saved_file(path);
+        const char* value = nullptr;
+        saved_file.get_dataset().findAndGetString(DCM_PatientID, value);
+        CHECK(std::string(value) == "BBBB");
+    }
+
+    SECTION("A value with a different length is not patched") {
+        REQUIRE(element->putString("BBBBBB").good());
+        file.mark_modified(DCM_PatientID);
+
+        CHECK(!file.try_patch_file());
+        CHECK(file.has_unsaved_changes());
+    }
+
+    SECTION("Untracked changes are not patched") {
+        REQUIRE(element->putString("BBBB").good());
+        file.set_unsaved_changes(true);
+
+        CHECK(!file.try_patch_file());
+    }
+}
+
+TEST_CASE("Save a file by copying its pixel data") {
+    Temp_dir temp_dir;
+    fs::path path = temp_dir.path() / "file";
+    std::vector<Uint8> pixels(64 * 1024);
+    for(size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<Uint8>(i % 251);
+    }
+    {
+        DcmFileFormat file;
+        REQUIRE(file.getDataset()->putAndInsertString(DCM_PatientName, "Doe^John").good());
+        REQUIRE(file.getDataset()->putAndInsertUint8Array(DCM_PixelData, pixels.data(), pixels.size()).good());
+        REQUIRE(file.saveFile(path.string().c_str(), EXS_LittleEndianExplicit).good());
+    }
+    Dicom_file file(path);
+    DcmElement* pixel_data = nullptr;
+    REQUIRE(file.get_dataset().findAndGetElement(DCM_PixelData, pixel_data).good());
+    REQUIRE(!pixel_data->valueLoaded());
+
+    SECTION("A changed header is written and the pixel data is left on disk") {
+        REQUIRE(file.get_dataset().putAndInsertString(DCM_PatientName, "Doe^Johnathan").good());
+        file.mark_modified(DCM_PatientName);
+
+        REQUIRE(file.try_stream_file(path));
+        CHECK(file.has_staged_file());
+        file.commit_staged_file();
+        CHECK(!file.has_unsaved_changes());
+        CHECK(!pixel_data->valueLoaded());
+
+        const Uint8* value = nullptr;
+        REQUIRE(file.get_dataset().findAndGetUint8Array(DCM_PixelData, value).good());
+        CHECK(std::equal(pixels.begin(), pixels.end(), value));
+
+        Dicom_file saved_file(path);
+        const char* name = nullptr;
+        saved_file.get_dataset().findAndGetString(DCM_PatientName, name);
+        CHECK(std::string(name) == "Doe^Johnathan");
+        REQUIRE(saved_file.get_dataset().findAndGetUint8Array(DCM_PixelData, value).good());
+        CHECK(std::equal(pixels.begin(), pixels.end(), value));
+    }
+
+    SECTION("Changed pixel data is not copied") {
+        file.mark_modified(DCM_PixelData);
+
+        CHECK(!file.try_stream_file(path));
+        CHECK(!file.has_staged_file());
+        CHECK(file.has_unsaved_changes());
+    }
+}
+
+static DcmPixelItem* get_fragment(Dicom_file& file, unsigned long index) {
+    DcmElement* element = nullptr;
+    REQUIRE(file.get_dataset().findAndGetElement(DCM_PixelData, element).good());
+    DcmPixelSequence* sequence = nullptr;
+    REQUIRE(static_cast<DcmPixelData*>(element)->getEncapsulatedRepresentation(EXS_RLELossless, nullptr,
+        sequence).good());
+    DcmPixelItem* fragment = nullptr;
+    REQUIRE(sequence->getItem(fragment, index).good());
+    return fragment;
+}
+
+TEST_CASE("Save a file with encapsulated pixel data by copying its fragments") {
+    Temp_dir temp_dir;
+    fs::path path = temp_dir.path() / "file";
+    std::vector<Uint8> pixels(64 * 1024);
+    for(size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<Uint8>(i % 251);
+    }
+    {
+        DcmFileFormat file;
+        auto sequence = new DcmPixelSequence(DCM_PixelSequenceTag);
+        REQUIRE(sequence->insert(new DcmPixelItem(DCM_PixelItemTag)).good());
+        auto fragment = new DcmPixelItem(DCM_PixelItemTag);
+        REQUIRE(fragment->putUint8Array(pixels.data(), pixels.size()).good());
+        REQUIRE(sequence->insert(fragment).good());
+        auto pixel_data = new DcmPixelData(DCM_PixelData);
+        pixel_data->putOriginalRepresentation(EXS_RLELossless, nullptr, sequence);
+        REQUIRE(file.getDataset()->putAndInsertString(DCM_PatientName, "Doe^John").good());
+        REQUIRE(file.getDataset()->insert(pixel_data).good());
+        REQUIRE(file.saveFile(path.string().c_str(), EXS_RLELossless).good());
+    }
+    Dicom_file file(path);
+    DcmPixelItem* fragment = get_fragment(file, 1);
+    REQUIRE(!fragment->valueLoaded());
+
+    REQUIRE(file.get_dataset().putAndInsertString(DCM_PatientName, "Doe^Johnathan").good());
+    file.mark_modified(DCM_PatientName);
+    REQUIRE(file.try_stream_file(path));
+    file.commit_staged_file();
+    CHECK(!fragment->valueLoaded());
+
+    Uint8* value = nullptr;
+    REQUIRE(fragment->getUint8Array(value).good());
+    CHECK(std::equal(pixels.begin(), pixels.end(), value));
+
+    Dicom_file saved_file(path);
+    const char* name = nullptr;
+    saved_file.get_dataset().findAndGetString(DCM_PatientName, name);
+    CHECK(std::string(name) == "Doe^Johnathan");
+    REQUIRE(get_fragment(saved_file, 1)->getUint8Array(value).good());
+    CHECK(std::equal(pixels.begin(), pixels.end(), value));
+}
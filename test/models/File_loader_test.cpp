@@ -0,0 +1,118 @@
+#include "common/File_util.h"
+#include "models/Dicom_files.h"
+#include "models/File_loader.h"
+#include "mocks/Progress_token_stub.h"
+#include "test_constants.h"
+#include "test_utils/Check_event.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+class Progress_token_recorder : public Progress_token
+{
+public:
+    void set_max_progress(int max) override {m_max = max;}
+    void increment_progress() override {
+        if(++m_progress > m_max) {
+            m_passed_max = true;
+        }
+    }
+    bool cancelled() const override {return false;}
+
+    std::atomic<int> m_max{0};
+    std::atomic<int> m_progress{0};
+    std::atomic<bool> m_passed_max{false};
+};
+
+TEST_CASE("Load files in parallel") {
+    Dicom_files files;
+    Progress_token_stub progress_stub;
+    File_loader loader(files, progress_stub);
+    loader.set_thread_count(4);
+
+    SECTION("Files are committed in the order they were given") {
+        std::vector<fs::path> paths;
+        for(int i = 0; i < 20; ++i) {
+            paths.push_back(data_path / (i % 2 == 0 ? "new-file.dcm" : "one-tag.dcm"));
+        }
+        loader.load_files(paths);
+
+        CHECK(loader.get_errors().empty());
+        CHECK(loader.get_opened_count() == paths.size());
+        REQUIRE(files.get_files().size() == 2);
+        CHECK(files.get_files()[0]->get_path() == paths[18]);
+        CHECK(files.get_files()[1]->get_path() == paths[19]);
+        CHECK(files.get_current_file() == files.get_files()[1].get());
+    }
+
+    SECTION("Files are committed in batches through the commit runner") {
+        int run_count = 0;
+        loader.set_commit_runner([&] (const std::function<void()>& commit) {
+            ++run_count;
+            commit();
+        });
+        Check_event check_files_added(files.files_added);
+        Check_event check_current_file_set(files.current_file_set);
+        loader.load_files({data_path / "new-file.dcm", data_path / "one-tag.dcm"});
+
+        CHECK(run_count == 1);
+        CHECK(files.get_files().size() == 2);
+        CHECK(files.get_current_file() == files.get_files()[1].get());
+    }
+
+    SECTION("Files that fail to load are reported") {
+        loader.load_files({data_path / "new-file.dcm", data_path / "does-not-exist.dcm"});
+
+        CHECK(files.get_files().size() == 1);
+        CHECK(loader.get_errors().size() == 1);
+    }
+
+    SECTION("A folder is walked recursively") {
+        Temp_dir temp_dir;
+        fs::create_directory(temp_dir.path() / "sub");
+        fs::copy_file(data_path / "new-file.dcm", temp_dir.path() / "a.dcm");
+        fs::copy_file(data_path / "one-tag.dcm", temp_dir.path() / "sub" / "b.dcm");
+        std::ofstream(temp_dir.path() / "notes.txt") << "not a DICOM file";
+        loader.load_folder(temp_dir.path());
+
+        CHECK(files.get_files().size() == 2);
+        CHECK(loader.get_errors().empty());
+        CHECK(loader.get_skipped_count() == 1);
+    }
+
+    SECTION("The temporary file of a save in progress is not loaded from a folder") {
+        Temp_dir temp_dir;
+        fs::copy_file(data_path / "new-file.dcm", temp_dir.path() / "a.dcm");
+        const fs::path temp_path = File_util::create_temp_file(temp_dir.path() / "a.dcm");
+        fs::copy_file(data_path / "new-file.dcm", temp_path, fs::copy_options::overwrite_existing);
+        loader.load_folder(temp_dir.path());
+
+        REQUIRE(files.get_files().size() == 1);
+        CHECK(files.get_files()[0]->get_path() == temp_dir.path() / "a.dcm");
+        CHECK(loader.get_skipped_count() == 0);
+    }
+}
+
+TEST_CASE("The progress maximum grows while a folder is walked") {
+    Temp_dir temp_dir;
+    for(int i = 0; i < 10; ++i) {
+        fs::copy_file(data_path / "one-tag.dcm", temp_dir.path() / (std::to_string(i) + ".dcm"));
+    }
+    Dicom_files files;
+    Progress_token_recorder progress_recorder;
+    File_loader loader(files, progress_recorder);
+    loader.set_thread_count(4);
+    loader.load_folder(temp_dir.path());
+
+    CHECK(progress_recorder.m_max == 10);
+    CHECK(progress_recorder.m_progress == 10);
+    CHECK(!progress_recorder.m_passed_max);
+}
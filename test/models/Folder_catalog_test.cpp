@@ -0,0 +1,84 @@
+#include "models/Dicom_files.h"
+#include "models/File_loader.h"
+#include "models/Folder_catalog.h"
+#include "mocks/Progress_token_stub.h"
+#include "test_constants.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+TEST_CASE("Folder catalog") {
+    Temp_dir temp_dir;
+    const fs::path root = temp_dir.path() / "folder";
+    const fs::path catalog_path = temp_dir.path() / "cache" / "folder.catalog";
+    Folder_catalog catalog(root);
+
+    Folder_catalog::Entry entry;
+    entry.size = 1234;
+    entry.modified_time = 5678;
+    entry.summary.patient_id = "PAT1";
+    entry.summary.series_instance_uid = "1.2.3";
+    entry.summary.image_position_patient = "0\\0\\-12.5";
+    catalog.put(root / "sub" / "a.dcm", entry);
+
+    SECTION("Entries survive a save and load") {
+        catalog.save(catalog_path);
+        Folder_catalog loaded(root);
+        loaded.load(catalog_path);
+
+        REQUIRE(loaded.size() == 1);
+        const File_summary* summary = loaded.find(root / "sub" / "a.dcm", 1234, 5678);
+        REQUIRE(summary != nullptr);
+        CHECK(summary->patient_id == "PAT1");
+        CHECK(summary->series_instance_uid == "1.2.3");
+        CHECK(summary->image_position_patient == "0\\0\\-12.5");
+    }
+
+    SECTION("A changed file is not found") {
+        CHECK(catalog.find(root / "sub" / "a.dcm", 1235, 5678) == nullptr);
+        CHECK(catalog.find(root / "sub" / "a.dcm", 1234, 5679) == nullptr);
+        CHECK(catalog.find(root / "b.dcm", 1234, 5678) == nullptr);
+    }
+
+    SECTION("A missing catalog file gives an empty catalog") {
+        catalog.load(temp_dir.path() / "missing.catalog");
+
+        CHECK(catalog.size() == 0);
+    }
+
+    SECTION("A corrupt catalog file throws") {
+        fs::create_directories(catalog_path.parent_path());
+        std::ofstream(catalog_path) << "not a catalog";
+
+        CHECK_THROWS(catalog.load(catalog_path));
+    }
+}
+
+TEST_CASE("Reopen a folder from its catalog") {
+    Temp_dir temp_dir;
+    fs::copy_file(data_path / "new-file.dcm", temp_dir.path() / "a.dcm");
+    fs::copy_file(data_path / "one-tag.dcm", temp_dir.path() / "b.dcm");
+    Folder_catalog catalog(temp_dir.path());
+    Progress_token_stub progress_stub;
+    {
+        Dicom_files files;
+        File_loader loader(files, progress_stub);
+        loader.set_catalog(&catalog);
+        loader.load_folder(temp_dir.path());
+
+        CHECK(loader.get_catalog_hit_count() == 0);
+        CHECK(catalog.size() == 2);
+    }
+    Dicom_files files;
+    File_loader loader(files, progress_stub);
+    loader.set_catalog(&catalog);
+    loader.load_folder(temp_dir.path());
+
+    CHECK(loader.get_catalog_hit_count() == 2);
+    CHECK(files.get_files().size() == 2);
+    CHECK(files.get_current_file()->is_fully_loaded());
+}
@@ -0,0 +1,65 @@
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "test_utils/Image_file.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <memory>
+
+TEST_CASE("Frame cache") {
+    Temp_dir temp_dir;
+    const fs::path path = temp_dir.path() / "image.dcm";
+    Image_file_options image;
+    image.rows = 4;
+    image.columns = 4;
+    image.frame_count = 2;
+    save_image_file(path, image);
+    Dicom_files files;
+    Dataset_model dataset_model(files);
+    Frame_cache cache(files, dataset_model);
+    files.open_file(path);
+    Dicom_file& file = *files.get_current_file();
+
+    auto frame = cache.get_frame(file, 0);
+    REQUIRE(frame->error.empty());
+    CHECK(frame->width == 4);
+    CHECK(frame->height == 4);
+    CHECK(cache.get_size() > 0);
+
+    SECTION("A cached frame is shared") {
+        CHECK(cache.get_frame(file, 0) == frame);
+    }
+
+    SECTION("Editing an image attribute renders the frame again") {
+        dataset_model.add_element(QModelIndex(), "WindowCenter", "100");
+        CHECK(cache.get_frame(file, 0) != frame);
+    }
+
+    SECTION("Editing another attribute keeps the frame") {
+        dataset_model.add_element(QModelIndex(), "PatientID", "117");
+        CHECK(cache.get_frame(file, 0) == frame);
+    }
+
+    SECTION("A frame rendered before an invalidation is not cached") {
+        const uint64_t generation = cache.get_generation();
+        cache.invalidate(&file);
+        auto stale_frame = std::make_shared<const Rendered_frame>();
+        CHECK(cache.insert(file, 0, stale_frame, generation) == stale_frame);
+        CHECK(cache.find(file, 0) == nullptr);
+    }
+
+    SECTION("Closing the file drops its frames") {
+        files.clear_all_files();
+        CHECK(cache.get_size() == 0);
+    }
+
+    SECTION("Frames beyond the budget are evicted, but stay valid while used") {
+        cache.set_budget(0);
+        auto second_frame = cache.get_frame(file, 1);
+        REQUIRE(second_frame->error.empty());
+        CHECK(cache.find(file, 0) == nullptr);
+        CHECK(cache.find(file, 1) == second_frame);
+        CHECK(frame->width == 4);
+    }
+}
@@ -0,0 +1,118 @@
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "models/Frame_decoder.h"
+#include "test_utils/Image_file.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <dcmtk/dcmdata/dcrledrg.h>
+#include <dcmtk/dcmdata/dcrleerg.h>
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <cstdint>
+#include <variant>
+#include <vector>
+
+struct Rle_codec_registration
+{
+    Rle_codec_registration() {
+        DcmRLEEncoderRegistration::registerCodecs();
+        DcmRLEDecoderRegistration::registerCodecs();
+    }
+
+    ~Rle_codec_registration() {
+        DcmRLEEncoderRegistration::cleanup();
+        DcmRLEDecoderRegistration::cleanup();
+    }
+};
+
+TEST_CASE("Frame decoder") {
+    const unsigned long frame_count = 12;
+    Temp_dir temp_dir;
+    const fs::path path = temp_dir.path() / "frames.dcm";
+    Image_file_options image;
+    image.rows = 4;
+    image.columns = 4;
+    image.frame_count = frame_count;
+    save_image_file(path, image);
+    Dicom_files files;
+    Dataset_model dataset_model(files);
+    Frame_cache cache(files, dataset_model);
+    files.open_file(path);
+    Dicom_file& file = *files.get_current_file();
+    Frame_decoder decoder(cache);
+    decoder.set_thread_count(3);
+
+    SECTION("Requested frames are rendered into the cache, wrapping at the last frame") {
+        decoder.decode(file, 8, 6, frame_count);
+        decoder.wait();
+
+        for(unsigned long index : {8, 9, 10, 11, 0, 1}) {
+            auto frame = cache.find(file, index);
+            REQUIRE(frame != nullptr);
+            CHECK(frame->error.empty());
+            CHECK(frame->frame_count == frame_count);
+        }
+        CHECK(cache.find(file, 2) == nullptr);
+        CHECK(!decoder.is_decoding());
+    }
+
+    SECTION("Frames of a file with unsaved changes are rendered from a clone") {
+        dataset_model.add_element(QModelIndex(), "PatientID", "117");
+        decoder.decode(file, 0, frame_count, frame_count);
+        decoder.wait();
+        CHECK(cache.find(file, frame_count - 1) != nullptr);
+    }
+
+    SECTION("Cancelling stops the workers") {
+        decoder.decode(file, 0, frame_count, frame_count);
+        decoder.cancel();
+        CHECK(!decoder.is_decoding());
+    }
+}
+
+TEST_CASE("Frame decoder with encapsulated pixel data") {
+    const unsigned long frame_count = 6;
+    Rle_codec_registration codec_registration;
+    Temp_dir temp_dir;
+    const fs::path path = temp_dir.path() / "rle.dcm";
+    Image_file_options image;
+    image.rows = 4;
+    image.columns = 4;
+    image.frame_count = frame_count;
+    image.transfer_syntax = EXS_RLELossless;
+    save_image_file(path, image);
+    Dicom_files files;
+    Dataset_model dataset_model(files);
+    Frame_cache cache(files, dataset_model);
+    files.open_file(path);
+    Dicom_file& file = *files.get_current_file();
+    REQUIRE(DcmXfer(file.get_dataset().getOriginalXfer()).isEncapsulated());
+    Frame_decoder decoder(cache);
+    decoder.set_thread_count(3);
+
+    SECTION("Compressed frames are decoded in parallel to their own values") {
+        decoder.decode(file, 1, frame_count - 1, frame_count);
+        decoder.wait();
+
+        for(unsigned long index = 1; index < frame_count; ++index) {
+            auto frame = cache.find(file, index);
+            REQUIRE(frame != nullptr);
+            CHECK(frame->error.empty());
+            // The 8-bit values are kept at their own depth.
+            auto values = std::get_if<std::vector<uint8_t>>(&frame->modality_values);
+            REQUIRE(values != nullptr);
+            REQUIRE(values->size() == 16);
+            CHECK(values->front() == index * 16);
+            CHECK(values->back() == index * 16 + 15);
+        }
+    }
+
+    SECTION("Frames decoded after the file is saved are not cached") {
+        decoder.decode(file, 0, frame_count, frame_count);
+        file.set_unsaved_changes(true);
+        files.save_current_file_as(path);
+        decoder.cancel();
+        CHECK(cache.get_size() == 0);
+    }
+}
@@ -0,0 +1,48 @@
+#include "models/Frame_pacer.h"
+
+#include <catch2/catch.hpp>
+
+using namespace std::chrono_literals;
+
+TEST_CASE("Testing Frame_pacer") {
+
+    Frame_pacer pacer(16ms);
+    const Frame_pacer::Clock::time_point start;
+
+    SECTION("the first request is repainted at once") {
+        CHECK(pacer.request_frame(start) == 0us);
+	}
+    SECTION("requests while a repaint is scheduled are coalesced") {
+        REQUIRE(pacer.request_frame(start));
+        CHECK(!pacer.request_frame(start + 1ms));
+        CHECK(!pacer.request_frame(start + 5ms));
+	}
+    SECTION("a repaint is delayed until a frame after the last one started") {
+        REQUIRE(pacer.request_frame(start));
+        pacer.start_frame(start);
+        pacer.finish_frame(start + 2ms);
+        CHECK(pacer.request_frame(start + 4ms) == 12ms);
+	}
+    SECTION("a repaint after a frame has passed is not delayed") {
+        pacer.start_frame(start);
+        pacer.finish_frame(start + 2ms);
+        CHECK(pacer.request_frame(start + 20ms) == 0us);
+	}
+    SECTION("a scheduled repaint that never started is scheduled again") {
+        REQUIRE(pacer.request_frame(start));
+        CHECK(pacer.request_frame(start + 20ms) == 0us);
+	}
+    SECTION("frame times are measured against the frame interval") {
+        pacer.start_frame(start);
+        pacer.finish_frame(start + 4ms);
+        pacer.start_frame(start + 16ms);
+        pacer.finish_frame(start + 36ms);
+
+        const Frame_stats stats = pacer.take_stats();
+        CHECK(stats.frame_count == 2);
+        CHECK(stats.over_budget_count == 1);
+        CHECK(stats.total_time == 24ms);
+        CHECK(stats.max_time == 20ms);
+        CHECK(pacer.take_stats().frame_count == 0);
+	}
+}
@@ -0,0 +1,73 @@
+#include "models/Image_pyramid.h"
+
+#include <catch2/catch.hpp>
+#include <QColor>
+#include <QImage>
+#include <algorithm>
+#include <vector>
+
+TEST_CASE("Testing Image_pyramid") {
+
+    std::vector<QRect> requested_rects;
+    Image_pyramid pyramid(QSize(1000, 600), [&] (const QRect& rect, uint32_t* pixels, size_t stride) {
+        requested_rects.push_back(rect);
+        for(int y = 0; y < rect.height(); ++y) {
+            std::fill_n(pixels + static_cast<size_t>(y) * stride, rect.width(), qRgb(10, 20, 30));
+        }
+    });
+
+    SECTION("levels halve the size until the image fits one tile") {
+        REQUIRE(pyramid.get_level_count() == 3);
+        CHECK(pyramid.get_level_size(0) == QSize(1000, 600));
+        CHECK(pyramid.get_level_size(1) == QSize(500, 300));
+        CHECK(pyramid.get_level_size(2) == QSize(250, 150));
+	}
+    SECTION("the level is chosen so it is never magnified") {
+        CHECK(pyramid.get_level(3.0) == 0);
+        CHECK(pyramid.get_level(1.0) == 0);
+        CHECK(pyramid.get_level(0.6) == 0);
+        CHECK(pyramid.get_level(0.5) == 1);
+        CHECK(pyramid.get_level(0.3) == 1);
+        CHECK(pyramid.get_level(0.2) == 2);
+        CHECK(pyramid.get_level(0.01) == 2);
+	}
+    SECTION("the nearest level is chosen for an untiled image, down to a few pixels") {
+        CHECK(Image_pyramid::get_nearest_level(2.0, QSize(1024, 512)) == 0);
+        CHECK(Image_pyramid::get_nearest_level(0.8, QSize(1024, 512)) == 0);
+        CHECK(Image_pyramid::get_nearest_level(0.6, QSize(1024, 512)) == 1);
+        CHECK(Image_pyramid::get_nearest_level(0.2, QSize(1024, 512)) == 2);
+        CHECK(Image_pyramid::get_nearest_level(1.0 / 32, QSize(1024, 512)) == 5);
+        CHECK(Image_pyramid::get_nearest_level(1.0 / 4096, QSize(1024, 512)) == 9);
+	}
+    SECTION("only tiles intersecting the rect are listed") {
+        const std::vector<QPoint> tiles = pyramid.get_tiles(0, QRectF(300, 100, 300, 100));
+        CHECK(tiles == std::vector<QPoint>{{1, 0}, {2, 0}});
+
+        CHECK(pyramid.get_tiles(0, QRectF(-500, -500, 2000, 2000)).size() == 12);
+        CHECK(pyramid.get_tiles(1, QRectF(0, 0, 1000, 600)).size() == 4);
+        CHECK(pyramid.get_tiles(0, QRectF(2000, 0, 100, 100)).empty());
+	}
+    SECTION("only the requested tile is read from the source, clipped at the image edge") {
+        const QImage tile = pyramid.get_tile(0, {3, 2});
+        CHECK(tile.format() == QImage::Format_RGB32);
+        CHECK(tile.size() == QSize(232, 88));
+        CHECK(tile.pixel(0, 0) == qRgb(10, 20, 30));
+        CHECK(requested_rects == std::vector<QRect>{QRect(768, 512, 232, 88)});
+
+        pyramid.get_tile(0, {3, 2});
+        CHECK(requested_rects.size() == 1);
+	}
+    SECTION("tiles of higher levels are downsampled from the level below") {
+        const QImage tile = pyramid.get_tile(2, {0, 0});
+        CHECK(tile.size() == QSize(250, 150));
+        CHECK(tile.pixel(0, 0) == qRgb(10, 20, 30));
+        CHECK(tile.pixel(249, 149) == qRgb(10, 20, 30));
+        CHECK(requested_rects.size() == 12);
+	}
+    SECTION("tiles beyond the budget are built again") {
+        pyramid.set_budget(0);
+        const QImage first = pyramid.get_tile(0, {0, 0});
+        pyramid.get_tile(0, {1, 0});
+        CHECK(pyramid.get_tile(0, {0, 0}) == first);
+	}
+}
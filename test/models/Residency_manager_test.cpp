@@ -0,0 +1,57 @@
+#include "models/Dicom_file.h"
+#include "models/Residency_manager.h"
+#include "test_constants.h"
+
+#include <catch2/catch.hpp>
+
+TEST_CASE("Residency manager") {
+    Dicom_file file_1(data_path / "new-file.dcm");
+    Dicom_file file_2(data_path / "one-tag.dcm");
+    Residency_manager manager(0);
+
+    SECTION("The least recently used file is unloaded when the budget is exceeded") {
+        manager.touch(file_1);
+        CHECK(!file_1.is_summary_only());
+
+        manager.touch(file_2);
+        CHECK(file_1.is_summary_only());
+        CHECK(!file_2.is_summary_only());
+        CHECK(manager.get_resident_size() == file_2.get_memory_usage());
+    }
+
+    SECTION("Files with unsaved changes are not unloaded") {
+        file_1.set_unsaved_changes(true);
+        manager.touch(file_1);
+        manager.touch(file_2);
+
+        CHECK(!file_1.is_summary_only());
+    }
+
+    SECTION("The file to keep is not unloaded") {
+        manager.touch(file_1);
+        manager.touch(file_2, &file_1);
+
+        CHECK(!file_1.is_summary_only());
+    }
+
+    SECTION("Nothing is unloaded within the budget") {
+        manager.set_budget(file_1.get_memory_usage() + file_2.get_memory_usage());
+        manager.touch(file_1);
+        manager.touch(file_2);
+
+        CHECK(!file_1.is_summary_only());
+    }
+
+    SECTION("An unloaded file keeps its summary and can be loaded again") {
+        const File_summary summary = file_1.get_summary();
+        manager.touch(file_1);
+        manager.touch(file_2);
+        REQUIRE(file_1.is_summary_only());
+
+        CHECK(file_1.get_summary().sop_class_uid == summary.sop_class_uid);
+        CHECK(file_1.get_summary().transfer_syntax_uid == summary.transfer_syntax_uid);
+        file_1.load_fully();
+        CHECK(file_1.is_fully_loaded());
+        CHECK(!file_1.is_summary_only());
+    }
+}
@@ -0,0 +1,53 @@
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Frame_cache.h"
+#include "models/Series_navigator.h"
+#include "test_utils/Image_file.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <memory>
+#include <string>
+
+TEST_CASE("Series navigator") {
+    Temp_dir temp_dir;
+    Dicom_files files;
+    Dataset_model dataset_model(files);
+    Frame_cache cache(files, dataset_model);
+    Series_navigator navigator(files, dataset_model, cache);
+    navigator.set_prefetch_distance(2);
+
+    // Files that are added without becoming current are only parsed up to the pixel data.
+    Load_options options;
+    options.header_only = true;
+
+    for(int i = 4; i >= 1; --i) {
+        const fs::path path = temp_dir.path() / (std::to_string(i) + ".dcm");
+        Image_file_options image;
+        image.series_uid = "1.2.3";
+        image.instance_number = i;
+        save_image_file(path, image);
+        files.add_file(std::make_unique<Dicom_file>(path, options));
+    }
+    Dicom_file* first = navigator.get_stack().get_files(*files.get_files().front())[0];
+    REQUIRE(first->get_path().filename() == "1.dcm");
+    files.set_current_file(first);
+
+    SECTION("Neighbors of the current file are parsed and rendered in the background") {
+        navigator.get_prefetcher().wait();
+        Dicom_file* second = navigator.get_stack().get_neighbor(*first, 1);
+        CHECK(cache.find(*second, 0) != nullptr);
+        CHECK(!second->is_fully_loaded());
+
+        REQUIRE(navigator.step(1));
+        CHECK(files.get_current_file() == second);
+        CHECK(second->is_fully_loaded());
+    }
+
+    SECTION("Stepping stops at the ends of the stack") {
+        CHECK(!navigator.step(-1));
+        CHECK(files.get_current_file() == first);
+        CHECK(navigator.step(10));
+        CHECK(files.get_current_file() == navigator.get_stack().get_files(*first).back());
+    }
+}
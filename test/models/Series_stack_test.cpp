@@ -0,0 +1,102 @@
+#include "models/Dataset_model.h"
+#include "models/Dicom_files.h"
+#include "models/Series_stack.h"
+#include "test_utils/Temp_dir.h"
+
+#include <catch2/catch.hpp>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <string>
+#include <vector>
+
+static void save_slice(const fs::path& path, const std::string& instance_number, const std::string& position) {
+    DcmFileFormat file;
+    DcmDataset& dataset = *file.getDataset();
+    REQUIRE(dataset.putAndInsertString(DCM_SeriesInstanceUID, "1.2.3").good());
+    REQUIRE(dataset.putAndInsertString(DCM_InstanceNumber, instance_number.c_str()).good());
+
+    if(!position.empty()) {
+        REQUIRE(dataset.putAndInsertString(DCM_ImagePositionPatient, position.c_str()).good());
+        REQUIRE(dataset.putAndInsertString(DCM_ImageOrientationPatient, "1\\0\\0\\0\\1\\0").good());
+    }
+    REQUIRE(file.saveFile(path.string().c_str(), EXS_LittleEndianExplicit).good());
+}
+
+static std::vector<std::string> get_names(const std::vector<Dicom_file*>& files) {
+    std::vector<std::string> names;
+    for(Dicom_file* file : files) {
+        names.push_back(file->get_path().filename().string());
+    }
+    return names;
+}
+
+TEST_CASE("Series stack") {
+    Temp_dir temp_dir;
+    Dicom_files files;
+    Dataset_model dataset_model(files);
+    Series_stack stack(files, dataset_model);
+
+    SECTION("Slices are sorted along the slice normal") {
+        save_slice(temp_dir.path() / "a.dcm", "1", "0\\0\\20");
+        save_slice(temp_dir.path() / "b.dcm", "2", "0\\0\\-10");
+        save_slice(temp_dir.path() / "c.dcm", "3", "0\\0\\5");
+        for(const char* name : {"a.dcm", "b.dcm", "c.dcm"}) {
+            files.open_file(temp_dir.path() / name);
+        }
+        Dicom_file& file = *files.get_current_file();
+        CHECK(get_names(stack.get_files(file)) == std::vector<std::string>{"b.dcm", "c.dcm", "a.dcm"});
+        CHECK(stack.get_position(file) == 1);
+    }
+
+    SECTION("Slices without a position are sorted by Instance Number") {
+        save_slice(temp_dir.path() / "a.dcm", "10", "");
+        save_slice(temp_dir.path() / "b.dcm", "2", "0\\0\\5");
+        save_slice(temp_dir.path() / "c.dcm", "7", "");
+        for(const char* name : {"a.dcm", "b.dcm", "c.dcm"}) {
+            files.open_file(temp_dir.path() / name);
+        }
+        Dicom_file& file = *files.get_current_file();
+        CHECK(get_names(stack.get_files(file)) == std::vector<std::string>{"b.dcm", "c.dcm", "a.dcm"});
+    }
+
+    SECTION("Neighbors are listed nearest first, in the direction of travel first") {
+        for(int i = 0; i < 5; ++i) {
+            const std::string name = std::to_string(i) + ".dcm";
+            save_slice(temp_dir.path() / name, std::to_string(i + 1), "");
+            files.open_file(temp_dir.path() / name);
+        }
+        Dicom_file& file = *stack.get_files(*files.get_current_file())[1];
+        CHECK(get_names(stack.get_neighbors(file, 2, 1)) == std::vector<std::string>{"2.dcm", "0.dcm", "3.dcm"});
+        CHECK(get_names(stack.get_neighbors(file, 2, -1)) == std::vector<std::string>{"0.dcm", "2.dcm", "3.dcm"});
+        CHECK(stack.get_neighbor(file, -5)->get_path().filename() == "0.dcm");
+        CHECK(stack.get_neighbor(file, 2)->get_path().filename() == "3.dcm");
+    }
+
+    SECTION("Slices are sorted again when an attribute of the order is edited") {
+        for(int i = 0; i < 3; ++i) {
+            const std::string name = std::to_string(i) + ".dcm";
+            save_slice(temp_dir.path() / name, std::to_string(i + 1), "");
+            files.open_file(temp_dir.path() / name);
+        }
+        Dicom_file& file = *files.get_current_file();
+        REQUIRE(get_names(stack.get_files(file)) == std::vector<std::string>{"0.dcm", "1.dcm", "2.dcm"});
+        REQUIRE(file.get_dataset().putAndInsertString(DCM_InstanceNumber, "0").good());
+
+        SECTION("Edits of other attributes keep the order") {
+            Dataset_change change;
+            change.top_level_tags = {DCM_PatientName};
+            dataset_model.dataset_changed(change);
+            CHECK(get_names(stack.get_files(file)) == std::vector<std::string>{"0.dcm", "1.dcm", "2.dcm"});
+        }
+        SECTION("An edit of Instance Number of the current file") {
+            Dataset_change change;
+            change.top_level_tags = {DCM_InstanceNumber};
+            dataset_model.dataset_changed(change);
+            CHECK(get_names(stack.get_files(file)) == std::vector<std::string>{"2.dcm", "0.dcm", "1.dcm"});
+        }
+        SECTION("An edit of all files") {
+            files.all_files_edited();
+            CHECK(get_names(stack.get_files(file)) == std::vector<std::string>{"2.dcm", "0.dcm", "1.dcm"});
+        }
+    }
+}
@@ -1,8 +1,10 @@
+#include "models/Image_pyramid.h"
 #include "models/Transform_tool.h"
 
 #include <catch2/catch.hpp>
 
 #include <QMouseEvent>
+#include <QSize>
 #include <QTransform>
 
 SCENARIO("Testing Transform_tool") {
@@ -98,4 +100,25 @@ SCENARIO("Testing Transform_tool") {
 			}
 		}
 	}
+
+    GIVEN("a transform tool in scale mode for a large image") {
+        Transform_tool transform_tool;
+        transform_tool.set_scale_mode();
+        const QSize image_size(4096, 2048);
+        transform_tool.set_image_size(image_size);
+
+		WHEN("zooming out as far as possible") {
+            transform_tool.mouse_press({QEvent::MouseButtonPress, {10, 20},
+                    Qt::LeftButton, Qt::NoButton, Qt::NoModifier});
+
+            transform_tool.mouse_move({QEvent::MouseMove, {10, 1000},
+                    Qt::NoButton, Qt::LeftButton, Qt::NoModifier});
+
+			THEN("the image is scaled to a few hundred pixels, and drawn from a level above 2") {
+                QTransform transform = transform_tool.get_transform();
+                CHECK(transform.m11() == Approx(1.0 / 16));
+                CHECK(Image_pyramid::get_nearest_level(transform.m11(), image_size) == 4);
+			}
+		}
+	}
 }
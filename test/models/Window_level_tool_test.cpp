@@ -0,0 +1,50 @@
+#include "models/Window_level_tool.h"
+
+#include <catch2/catch.hpp>
+
+#include <QMouseEvent>
+
+SCENARIO("Testing Window_level_tool") {
+
+    GIVEN("a window level tool with a window of width 256") {
+        Window_level_tool tool;
+        tool.set_window(100, 256);
+
+        WHEN("dragging right and up") {
+            tool.mouse_press({QEvent::MouseButtonPress, {10, 20},
+                    Qt::LeftButton, Qt::NoButton, Qt::NoModifier});
+
+            const bool has_changed = tool.mouse_move({QEvent::MouseMove, {20, 10},
+                    Qt::NoButton, Qt::LeftButton, Qt::NoModifier});
+
+            THEN("the window is wider and its center higher") {
+                CHECK(has_changed);
+                CHECK(tool.get_width() == Approx(266));
+                CHECK(tool.get_center() == Approx(110));
+            }
+        }
+
+        WHEN("moving without a pressed button") {
+            const bool has_changed = tool.mouse_move({QEvent::MouseMove, {500, 500},
+                    Qt::NoButton, Qt::NoButton, Qt::NoModifier});
+
+            THEN("the window is unchanged") {
+                CHECK(!has_changed);
+                CHECK(tool.get_width() == 256);
+                CHECK(tool.get_center() == 100);
+            }
+        }
+
+        WHEN("dragging far to the left") {
+            tool.mouse_press({QEvent::MouseButtonPress, {1000, 0},
+                    Qt::LeftButton, Qt::NoButton, Qt::NoModifier});
+
+            tool.mouse_move({QEvent::MouseMove, {0, 0},
+                    Qt::NoButton, Qt::LeftButton, Qt::NoModifier});
+
+            THEN("the width stays positive") {
+                CHECK(tool.get_width() == 1);
+            }
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#include "test_utils/Image_file.h"
+
+#include <catch2/catch.hpp>
+#include <dcmtk/dcmdata/dcdeftag.h>
+#include <dcmtk/dcmdata/dcfilefo.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+void save_image_file(const std::filesystem::path& path, const Image_file_options& options) {
+    DcmFileFormat file;
+    DcmDataset& dataset = *file.getDataset();
+    std::vector<Uint8> pixels(size_t{options.rows} * options.columns * options.frame_count);
+    for(size_t i = 0; i < pixels.size(); ++i) {
+        pixels[i] = static_cast<Uint8>(i);
+    }
+    if(!options.series_uid.empty()) {
+        REQUIRE(dataset.putAndInsertString(DCM_SeriesInstanceUID, options.series_uid.c_str()).good());
+    }
+    if(options.instance_number != 0) {
+        REQUIRE(dataset.putAndInsertString(DCM_InstanceNumber, std::to_string(options.instance_number).c_str()).good());
+    }
+    if(options.frame_count > 1) {
+        REQUIRE(dataset.putAndInsertString(DCM_NumberOfFrames, std::to_string(options.frame_count).c_str()).good());
+    }
+    REQUIRE(dataset.putAndInsertString(DCM_PhotometricInterpretation, "MONOCHROME2").good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_SamplesPerPixel, 1).good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_Rows, options.rows).good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_Columns, options.columns).good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_BitsAllocated, 8).good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_BitsStored, 8).good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_HighBit, 7).good());
+    REQUIRE(dataset.putAndInsertUint16(DCM_PixelRepresentation, 0).good());
+    REQUIRE(dataset.putAndInsertUint8Array(DCM_PixelData, pixels.data(), pixels.size()).good());
+    REQUIRE(dataset.chooseRepresentation(options.transfer_syntax, nullptr).good());
+    REQUIRE(file.saveFile(path.string().c_str(), options.transfer_syntax).good());
+}
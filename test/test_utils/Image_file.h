@@ -0,0 +1,20 @@
+#pragma once
+#include <dcmtk/dcmdata/dcxfer.h>
+#include <filesystem>
+#include <string>
+
+struct Image_file_options
+{
+    unsigned short rows = 2;
+    unsigned short columns = 2;
+    unsigned long frame_count = 1;
+    /** Left out when empty. */
+    std::string series_uid;
+    /** Left out when 0. */
+    int instance_number = 0;
+    E_TransferSyntax transfer_syntax = EXS_LittleEndianExplicit;
+};
+
+/** Save an 8-bit MONOCHROME2 image. Pixel i of the pixel data, counted
+ *  over all frames, has the value i modulo 256. */
+void save_image_file(const std::filesystem::path&, const Image_file_options& = Image_file_options());